@@ -8,6 +8,7 @@
 
 
 #include "lodepng.h"
+#include <algorithm>
 #include <iostream>
 #include <stdlib.h>
 #include <fstream>
@@ -97,79 +98,67 @@ int main(int inArgc, char *inArgv[])
     decode(lFilename.c_str(), lImage, lWidth, lHeight);
     outImage.resize((int)lWidth*(int)lHeight*4);
     
+    //Tuiles de calcul : lTileH lignes de lTileW pixels. Les lignes de
+    //l'image sont parcourues dans l'ordre de la mémoire (y, puis x) et les
+    //lTileH + lK - 1 morceaux de lignes lus par une tuile restent en cache
+    //d'une ligne à l'autre, même pour les images très larges.
+    const int lTileW = 256;
+    const int lTileH = 32;
+
     //Variables contenant des indices
     int fy, fx;
     //Variables temporaires pour les canaux de l'image
-    double lR, lG, lB;    
-    for(int x = lHalfK; x < (int)lWidth - lHalfK; x++)
+    double lR, lG, lB;
+    for (int ty = lHalfK; ty < (int)lHeight - lHalfK; ty += lTileH)
     {
-        for (int y = lHalfK; y < (int)lHeight - lHalfK; y++)
+        int tyFin = min(ty + lTileH, (int)lHeight - lHalfK);
+        for (int tx = lHalfK; tx < (int)lWidth - lHalfK; tx += lTileW)
         {
-            lR = 0.;
-            lG = 0.;
-            lB = 0.;
-            for (int j = -lHalfK; j <= lHalfK; j++) {
-                fy = j + lHalfK;
-                for (int i = -lHalfK; i <= lHalfK; i++) {
-                    fx = i + lHalfK;
-                    //R[x + i, y + j] = Im[x + i, y + j].R * Filter[i, j]
-                    lR += double(lImage[(y + j)*lWidth*4 + (x + i)*4    ]) * lFilter[fx + fy*lK];
-                    lG += double(lImage[(y + j)*lWidth*4 + (x + i)*4 + 1]) * lFilter[fx + fy*lK];
-                    lB += double(lImage[(y + j)*lWidth*4 + (x + i)*4 + 2]) * lFilter[fx + fy*lK];
-
+            int txFin = min(tx + lTileW, (int)lWidth - lHalfK);
+            for (int y = ty; y < tyFin; y++)
+            {
+                for (int x = tx; x < txFin; x++)
+                {
+                    lR = 0.;
+                    lG = 0.;
+                    lB = 0.;
+                    for (int j = -lHalfK; j <= lHalfK; j++) {
+                        fy = j + lHalfK;
+                        for (int i = -lHalfK; i <= lHalfK; i++) {
+                            fx = i + lHalfK;
+                            //R[x + i, y + j] = Im[x + i, y + j].R * Filter[i, j]
+                            lR += double(lImage[(y + j)*lWidth*4 + (x + i)*4    ]) * lFilter[fx + fy*lK];
+                            lG += double(lImage[(y + j)*lWidth*4 + (x + i)*4 + 1]) * lFilter[fx + fy*lK];
+                            lB += double(lImage[(y + j)*lWidth*4 + (x + i)*4 + 2]) * lFilter[fx + fy*lK];
+
+                        }
+                    }
+                    //protection contre la saturation
+                    if(lR<0.) {lR=0.;} if(lR>255.) {lR=255.;}
+                    if(lG<0.) {lG=0.;} if(lG>255.) {lG=255.;}
+                    if(lB<0.) {lB=0.;} if(lB>255.) {lB=255.;}
+                    //Placer le résultat dans l'image.
+                    outImage[y*lWidth*4 + x*4] = (unsigned char)lR;
+                    outImage[y*lWidth*4 + x*4 + 1] = (unsigned char)lG;
+                    outImage[y*lWidth*4 + x*4 + 2] = (unsigned char)lB;
+                    outImage[y*lWidth*4 + x*4 + 3] = lImage[y*lWidth*4 + x*4 + 3];
                 }
             }
-            //protection contre la saturation
-            if(lR<0.) {lR=0.;} if(lR>255.) {lR=255.;}
-            if(lG<0.) {lG=0.;} if(lG>255.) {lG=255.;}
-            if(lB<0.) {lB=0.;} if(lB>255.) {lB=255.;}
-            //Placer le résultat dans l'image.
-            outImage[y*lWidth*4 + x*4] = (unsigned char)lR;
-            outImage[y*lWidth*4 + x*4 + 1] = (unsigned char)lG;
-            outImage[y*lWidth*4 + x*4 + 2] = (unsigned char)lB;
-            outImage[y*lWidth*4 + x*4 + 3] = lImage[y*lWidth*4 + x*4 + 3];
         }
     }
     
-    //copie les bordures de l'image
-    for(int x = 0; x < lHalfK; x++)
-    {
-        for (int y = 0; y < (int)lHeight; y++)
-        {
-            outImage[y*lWidth*4 + x*4] = lImage[y*lWidth*4 + x*4];
-            outImage[y*lWidth*4 + x*4 + 1] = lImage[y*lWidth*4 + x*4 + 1];
-            outImage[y*lWidth*4 + x*4 + 2] = lImage[y*lWidth*4 + x*4 + 2];
-            outImage[y*lWidth*4 + x*4 + 3] = lImage[y*lWidth*4 + x*4 + 3];
-        }
-    }
-    for(int x = (int)lWidth-lHalfK; x < (int)lWidth; x++)
-    {
-        for (int y = 0; y < (int)lHeight; y++)
-        {
-            outImage[y*lWidth*4 + x*4] = lImage[y*lWidth*4 + x*4];
-            outImage[y*lWidth*4 + x*4 + 1] = lImage[y*lWidth*4 + x*4 + 1];
-            outImage[y*lWidth*4 + x*4 + 2] = lImage[y*lWidth*4 + x*4 + 2];
-            outImage[y*lWidth*4 + x*4 + 3] = lImage[y*lWidth*4 + x*4 + 3];
-        }
-    }
-    for(int x = lHalfK; x < (int)lWidth - lHalfK; x++)
+    //copie les bordures de l'image, ligne par ligne : les lignes du haut et
+    //du bas en entier, les lHalfK pixels de gauche et de droite des autres
+    for (int y = 0; y < (int)lHeight; y++)
     {
-        for (int y = 0; y < lHalfK; y++)
-        {
-            outImage[y*lWidth*4 + x*4] = lImage[y*lWidth*4 + x*4];
-            outImage[y*lWidth*4 + x*4 + 1] = lImage[y*lWidth*4 + x*4 + 1];
-            outImage[y*lWidth*4 + x*4 + 2] = lImage[y*lWidth*4 + x*4 + 2];
-            outImage[y*lWidth*4 + x*4 + 3] = lImage[y*lWidth*4 + x*4 + 3];
+        const unsigned char* lIn = &lImage[y*lWidth*4];
+        unsigned char* lOut = &outImage[y*lWidth*4];
+        if (y < lHalfK || y >= (int)lHeight - lHalfK) {
+            copy(lIn, lIn + lWidth*4, lOut);
         }
-    }
-    for(int x = lHalfK; x < (int)lWidth - lHalfK; x++)
-    {
-        for (int y = (int)lHeight - lHalfK; y < (int)lHeight; y++)
-        {
-            outImage[y*lWidth*4 + x*4] = lImage[y*lWidth*4 + x*4];
-            outImage[y*lWidth*4 + x*4 + 1] = lImage[y*lWidth*4 + x*4 + 1];
-            outImage[y*lWidth*4 + x*4 + 2] = lImage[y*lWidth*4 + x*4 + 2];
-            outImage[y*lWidth*4 + x*4 + 3] = lImage[y*lWidth*4 + x*4 + 3];
+        else {
+            copy(lIn, lIn + lHalfK*4, lOut);
+            copy(lIn + (lWidth - lHalfK)*4, lIn + lWidth*4, lOut + (lWidth - lHalfK)*4);
         }
     }
     
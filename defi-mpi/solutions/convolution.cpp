@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cstring>
 #include <fstream>
 #include <iostream>
@@ -121,6 +122,14 @@ public:
         ifs.close();
     }
 
+    /**
+     * Modifier la taille du noyau, avant d'en recevoir les valeurs
+     */
+    void redimensionner(size_type taille_) {
+        taille = taille_;
+        resize(taille * taille);
+    }
+
     inline size_type largeur() const { return taille; }
 
 private:
@@ -128,15 +137,96 @@ private:
 };
 
 
+/**
+ * Échanger les lignes de halo entre rangs : le rang r possède les lignes
+ * [debuts[r], debuts[r + 1]) et a besoin des lignes [hauts[r], bas[r]),
+ * reçues dans bande à partir de sa ligne hauts[r]
+ *
+ * À l'étape d, chaque rang envoie au rang + d les lignes de sa bande dans
+ * le halo du haut de celui-ci et reçoit du rang - d celles de son propre
+ * halo du haut, puis de même vers le bas (MPI_Sendrecv). Une seule étape
+ * suffit, sauf si la marge dépasse la hauteur des bandes voisines.
+ */
+static void echanger_halos(png_rgba * bande, int largeur, MPI_Datatype ligne,
+                           const std::vector<int> & debuts,
+                           const std::vector<int> & hauts,
+                           const std::vector<int> & bas, int rank, int size)
+{
+    // Nombre d'étapes, le même pour tous les rangs
+    int etapes = 0;
+    for (int q = 0; q < size; ++q) {
+        for (int r = q - 1; r >= 0 && debuts[r + 1] > hauts[q]; --r)
+            etapes = std::max(etapes, q - r);
+        for (int r = q + 1; r < size && debuts[r] < bas[q]; ++r)
+            etapes = std::max(etapes, r - q);
+    }
+
+    const int debut = debuts[rank];
+    const int fin = debuts[rank + 1];
+
+    // Lignes [y0, y1) de l'image, vides si y1 <= y0, et leur adresse
+    auto compte = [](int y0, int y1) { return std::max(0, y1 - y0); };
+    auto adresse = [&](int y) {
+        return bande + (size_t)(y - hauts[rank]) * largeur;
+    };
+
+    for (int d = 1; d <= etapes; ++d) {
+        const int dessous = (rank + d < size) ? rank + d : MPI_PROC_NULL;
+        const int dessus = (rank - d >= 0) ? rank - d : MPI_PROC_NULL;
+
+        // Vers le bas : halo du haut du rang dessous, reçu du rang dessus
+        int e0 = 0, e1 = 0, r0 = 0, r1 = 0;
+        if (dessous != MPI_PROC_NULL) {
+            e0 = std::max(debut, hauts[dessous]);
+            e1 = std::min(fin, debuts[dessous]);
+        }
+        if (dessus != MPI_PROC_NULL) {
+            r0 = std::max(debuts[dessus], hauts[rank]);
+            r1 = std::min(debuts[dessus + 1], debut);
+        }
+        MPI_Sendrecv(
+            adresse(compte(e0, e1) ? e0 : debut), compte(e0, e1), ligne,
+            dessous, 0,
+            adresse(compte(r0, r1) ? r0 : debut), compte(r0, r1), ligne,
+            dessus, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+        // Vers le haut : halo du bas du rang dessus, reçu du rang dessous
+        e0 = e1 = r0 = r1 = 0;
+        if (dessus != MPI_PROC_NULL) {
+            e0 = std::max(debut, debuts[dessus + 1]);
+            e1 = std::min(fin, bas[dessus]);
+        }
+        if (dessous != MPI_PROC_NULL) {
+            r0 = std::max(debuts[dessous], fin);
+            r1 = std::min(debuts[dessous + 1], bas[rank]);
+        }
+        MPI_Sendrecv(
+            adresse(compte(e0, e1) ? e0 : debut), compte(e0, e1), ligne,
+            dessus, 1,
+            adresse(compte(r0, r1) ? r0 : debut), compte(r0, r1), ligne,
+            dessous, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    }
+}
+
+
 /**
  * Produit de convolution - écrase l'image originale
  * https://fr.wikipedia.org/wiki/Produit_de_convolution
+ *
+ * Seul le rang 0 a l'image complète : il distribue à chaque rang sa bande
+ * de lignes, disjointe des autres (MPI_Scatterv), puis les rangs voisins
+ * échangent les marge lignes de halo de part et d'autre (MPI_Sendrecv). Les
+ * bandes filtrées sont rassemblées au rang 0 (MPI_Gatherv). Chaque rang
+ * n'alloue que sa bande avec marges.
  */
 static void prod_conv(LePNG & rgba, const Noyau & filtre, int rank, int size)
 {
-    // Dimensions originales
-    const int largeur = rgba.largeur();
-    const int hauteur = rgba.hauteur();
+    // Dimensions originales, connues du rang 0 seulement
+    png_uint_32 dimensions[2] = { rgba.largeur(), rgba.hauteur() };
+    MPI_Bcast(dimensions, 2, MPI_UNSIGNED, 0, MPI_COMM_WORLD);
+
+    const int largeur = dimensions[0];
+    const int hauteur = dimensions[1];
     if (rank == 0)
         std::cout << "Dimensions de l'image originale : " << largeur
             << " x " << hauteur << std::endl;
@@ -158,24 +248,56 @@ static void prod_conv(LePNG & rgba, const Noyau & filtre, int rank, int size)
             << stride - (marge_gauche + largeur) << ")" << std::endl;
     }
 
+    // Bande de chaque rang [debuts[r], debuts[r + 1]), disjointe des
+    // autres, et lignes lues [hauts[r], bas[r]) avec les halos
+    std::vector<int> debuts(size + 1);
+    std::vector<int> hauts(size), bas(size);
+    std::vector<int> comptes(size), deplacements(size);
+    for (int r = 0; r <= size; ++r)
+        debuts[r] = (int)((long long)r * hauteur / size);
+    for (int r = 0; r < size; ++r) {
+        hauts[r] = std::max(0, debuts[r] - marge);
+        bas[r] = std::min(hauteur, debuts[r + 1] + marge);
+        comptes[r] = debuts[r + 1] - debuts[r];
+        deplacements[r] = debuts[r];
+    }
+
+    const int debut = debuts[rank];
+    const int fin = debuts[rank + 1];
+    const int haut = hauts[rank];
+
+    // Comptes et déplacements en lignes : pas de débordement d'un int
+    // au-delà de 2 Gio d'image
+    MPI_Datatype ligne;
+    MPI_Type_contiguous(largeur * sizeof(png_rgba), MPI_BYTE, &ligne);
+    MPI_Type_commit(&ligne);
+
+    LePNG bande;
+    bande.redimensionner(largeur, bas[rank] - haut);
+
+    MPI_Scatterv(rank == 0 ? rgba.data() : NULL, comptes.data(),
+        deplacements.data(), ligne,
+        bande.data() + (size_t)(debut - haut) * largeur, comptes[rank],
+        ligne, 0, MPI_COMM_WORLD);
+
+    echanger_halos(bande.data(), largeur, ligne, debuts, hauts, bas,
+        rank, size);
+
+    // Lignes debut - marge .. fin + marge - 1 de l'image avec marges ; les
+    // marges du haut et du bas, en miroir, sont déjà dans la bande reçue
     LePNG im_temp;
-    im_temp.redimensionner(stride, marge + hauteur + marge);
+    im_temp.redimensionner(stride, marge + (fin - debut) + marge);
 
-    // Remplir les marges du haut et du bas
-    for (int i = 0; i < marge; ++i) {
-        for (int j = 0; j < largeur; ++j) {
-            im_temp[(marge - 1 - i) * stride + (marge_gauche + j)] =
-                rgba[i * largeur + j];
-            im_temp[(marge + hauteur + i) * stride + (marge_gauche + j)] =
-                rgba[(hauteur - 1 - i) * largeur + j];
-        }
-    }
+    for (int i = 0; i < (int)im_temp.hauteur(); ++i) {
+        int source = debut - marge + i;
+        if (source < 0)
+            source = -1 - source;
+        else if (source >= hauteur)
+            source = 2 * hauteur - 1 - source;
 
-    // Copier l'image originale
-    for (int i = 0; i < hauteur; ++i) {
         for (int j = 0; j < largeur; ++j) {
-            im_temp[(marge + i) * stride + (marge_gauche + j)] =
-                rgba[i * largeur + j];
+            im_temp[i * stride + (marge_gauche + j)] =
+                bande[(source - haut) * largeur + j];
         }
     }
 
@@ -192,11 +314,11 @@ static void prod_conv(LePNG & rgba, const Noyau & filtre, int rank, int size)
     if (rank == 0)
         std::cout << "Filtrage en cours ..." << std::endl;
 
-    int debut = rank * hauteur / size;
-    int fin = (rank + 1) * hauteur / size;
+    // Résultat dans la bande reçue, à partir de sa ligne debut
+    png_rgba * resultat = &bande[(debut - haut) * largeur];
 
     // Prod_conv[i, j] = Sum_ii(Sum_jj(Im[i+ii, j+jj] * Filtre[-ii, -jj]))
-    for (int i = debut; i < fin; ++i) {
+    for (int i = 0; i < fin - debut; ++i) {
         for (int j = 0; j < largeur; ++j) {
             double r = 0.;
             double g = 0.;
@@ -220,30 +342,33 @@ static void prod_conv(LePNG & rgba, const Noyau & filtre, int rank, int size)
             if (g < 0.) { g = 0.; } if (g > 255.) { g = 255.; }
             if (b < 0.) { b = 0.; } if (b > 255.) { b = 255.; }
 
-            // Placer le résultat dans l'image originale
-            rgba[i * largeur + j].r = r;
-            rgba[i * largeur + j].g = g;
-            rgba[i * largeur + j].b = b;
+            // Placer le résultat dans la bande
+            resultat[i * largeur + j].r = r;
+            resultat[i * largeur + j].g = g;
+            resultat[i * largeur + j].b = b;
         }
     }
 
-    if (rank == 0) {
-        MPI_Status etat;
+    MPI_Gatherv(resultat, comptes[rank], ligne,
+        rank == 0 ? rgba.data() : NULL, comptes.data(),
+        deplacements.data(), ligne, 0, MPI_COMM_WORLD);
 
-        for (int r = 1; r < size; ++r) {
-            debut = r * hauteur / size;
-            fin = (r + 1) * hauteur / size;
+    MPI_Type_free(&ligne);
+}
 
-            MPI_Recv(&rgba[debut * largeur],
-                (fin - debut) * largeur * sizeof(png_rgba),
-                MPI_BYTE, r, 456, MPI_COMM_WORLD, &etat);
-        }
-    }
-    else {
-        MPI_Send(&rgba[debut * largeur],
-            (fin - debut) * largeur * sizeof(png_rgba),
-            MPI_BYTE, 0, 456, MPI_COMM_WORLD);
-    }
+
+/**
+ * Diffuser le noyau du rang 0 aux autres rangs
+ */
+static void diffuser_noyau(Noyau & noyau, int rank)
+{
+    int taille = noyau.largeur();
+    MPI_Bcast(&taille, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+    if (rank != 0)
+        noyau.redimensionner(taille);
+
+    MPI_Bcast(noyau.data(), taille * taille, MPI_DOUBLE, 0, MPI_COMM_WORLD);
 }
 
 
@@ -268,28 +393,31 @@ int main(int argc, char *argv[])
         return MPI_Abort(MPI_COMM_WORLD, 1);
     }
 
+    // Le rang 0 seul lit les fichiers
     try {
         // Charger l'image originale
         std::string nom_fichier_png(argv[1]);
-        png.charger(nom_fichier_png);
+        if (rank == 0)
+            png.charger(nom_fichier_png);
     }
     catch (const std::string message) {
-        if (rank == 0)
-            std::cerr << "Erreur: " << message << std::endl;
+        std::cerr << "Erreur: " << message << std::endl;
         return MPI_Abort(MPI_COMM_WORLD, 2);
     }
 
     try {
         // Charger le noyau de convolution
         std::string nom_fichier_noyau(argv[2]);
-        noyau.charger(nom_fichier_noyau);
+        if (rank == 0)
+            noyau.charger(nom_fichier_noyau);
     }
     catch (const std::string message) {
-        if (rank == 0)
-            std::cerr << "Erreur: " << message << std::endl;
+        std::cerr << "Erreur: " << message << std::endl;
         return MPI_Abort(MPI_COMM_WORLD, 3);
     }
 
+    diffuser_noyau(noyau, rank);
+
     // Calcul principal
     prod_conv(png, noyau, rank, size);
 
@@ -0,0 +1,72 @@
+#ifndef BORDURE_HPP
+#define BORDURE_HPP
+
+#include <cstdlib>
+#include <string>
+
+
+/**
+ * Traitement des pixels lus hors de l'image par le noyau
+ */
+enum PolitiqueBord {
+    BORD_MIROIR,      // -1 -> 0, n -> n-1 (marges de ImageMarges)
+    BORD_REPLIQUE,    // -1 -> 0, n -> n-1, ... : pixel du bord répété
+    BORD_CIRCULAIRE,  // -1 -> n-1, n -> 0 : image périodique
+    BORD_CONSTANT,    // Valeur constante hors de l'image
+    BORD_ORIGINAL     // Pixels de bord non filtrés, copiés de l'original
+};
+
+static const char * const NOMS_BORDS[] = {
+    "miroir", "replique", "circulaire", "constante", "original"
+};
+
+
+/**
+ * Politique à partir de son nom ; "constante=v" fixe aussi la valeur
+ */
+static PolitiqueBord lire_politique_bord(const std::string & nom,
+                                         double & constante)
+{
+    for (int p = BORD_MIROIR; p <= BORD_ORIGINAL; ++p) {
+        if (nom == NOMS_BORDS[p])
+            return (PolitiqueBord)p;
+    }
+
+    const std::string prefixe = std::string(NOMS_BORDS[BORD_CONSTANT]) + "=";
+    if (nom.compare(0, prefixe.size(), prefixe) == 0) {
+        const char * valeur = nom.c_str() + prefixe.size();
+        char * fin;
+        constante = strtod(valeur, &fin);
+        if (fin == valeur || *fin != '\0')
+            throw "valeur constante invalide (" + nom + ").";
+        return BORD_CONSTANT;
+    }
+
+    throw "politique de bord inconnue (" + nom + ").";
+}
+
+
+/**
+ * Indice dans [0, n) lu à la place de x selon la politique, ou -1 pour la
+ * valeur constante (et pour l'original, dont les bords ne sont pas lus)
+ */
+static inline int remapper(int x, int n, PolitiqueBord politique)
+{
+    if (x >= 0 && x < n)
+        return x;
+
+    switch (politique) {
+        case BORD_MIROIR:
+            // Période 2n, même si la marge dépasse la taille de l'image
+            x = ((x % (2 * n)) + 2 * n) % (2 * n);
+            return (x < n) ? x : 2 * n - 1 - x;
+        case BORD_REPLIQUE:
+            return (x < 0) ? 0 : n - 1;
+        case BORD_CIRCULAIRE:
+            return ((x % n) + n) % n;
+        default:
+            return -1;
+    }
+}
+
+#endif
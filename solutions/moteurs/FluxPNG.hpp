@@ -0,0 +1,145 @@
+#ifndef FLUXPNG_HPP
+#define FLUXPNG_HPP
+
+#include <csetjmp>
+#include <cstdio>
+#include <string>
+
+#include "LePNG.hpp"
+
+
+/**
+ * Lecture d'un fichier PNG ligne par ligne, convertie en RGBA 8 bits :
+ * seule la ligne courante est en mémoire
+ */
+class LecteurPNG
+{
+public:
+    LecteurPNG(): fichier(NULL), png(NULL), info(NULL) {}
+
+    ~LecteurPNG() {
+        if (png)
+            png_destroy_read_struct(&png, &info, NULL);
+        if (fichier)
+            fclose(fichier);
+    }
+
+    void ouvrir(const std::string & nom_fichier) {
+        nom = nom_fichier;
+        fichier = fopen(nom.c_str(), "rb");
+        if (!fichier)
+            throw nom + " - n'a pas pu être ouvert.";
+
+        png = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+        info = png ? png_create_info_struct(png) : NULL;
+        if (!info)
+            throw nom + " - mémoire insuffisante pour libpng.";
+
+        if (setjmp(png_jmpbuf(png)))
+            throw nom + " - fichier PNG invalide.";
+
+        png_init_io(png, fichier);
+        png_read_info(png, info);
+
+        if (png_get_interlace_type(png, info) != PNG_INTERLACE_NONE)
+            throw nom + " - image entrelacée, illisible ligne par ligne.";
+
+        // Toute image devient RGBA 8 bits, comme avec PNG_FORMAT_RGBA
+        png_set_expand(png);
+        png_set_strip_16(png);
+        png_set_gray_to_rgb(png);
+        png_set_filler(png, 0xff, PNG_FILLER_AFTER);
+        png_read_update_info(png, info);
+    }
+
+    /**
+     * Ligne suivante de l'image, largeur() pixels
+     */
+    void lire_ligne(png_rgba * ligne) {
+        if (setjmp(png_jmpbuf(png)))
+            throw nom + " - erreur de lecture.";
+
+        png_read_row(png, (png_bytep)ligne, NULL);
+    }
+
+    png_uint_32 largeur() const { return png_get_image_width(png, info); }
+    png_uint_32 hauteur() const { return png_get_image_height(png, info); }
+
+private:
+    LecteurPNG(const LecteurPNG &);
+    LecteurPNG & operator=(const LecteurPNG &);
+
+    std::string nom;
+    FILE * fichier;
+    png_structp png;
+    png_infop info;
+};
+
+
+/**
+ * Écriture d'un fichier PNG RGBA 8 bits ligne par ligne
+ */
+class EcrivainPNG
+{
+public:
+    EcrivainPNG(): fichier(NULL), png(NULL), info(NULL) {}
+
+    ~EcrivainPNG() {
+        if (png)
+            png_destroy_write_struct(&png, &info);
+        if (fichier)
+            fclose(fichier);
+    }
+
+    void ouvrir(const std::string & nom_fichier, png_uint_32 largeur,
+                png_uint_32 hauteur) {
+        nom = nom_fichier;
+        fichier = fopen(nom.c_str(), "wb");
+        if (!fichier)
+            throw nom + " - n'a pas pu être créé.";
+
+        png = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+        info = png ? png_create_info_struct(png) : NULL;
+        if (!info)
+            throw nom + " - mémoire insuffisante pour libpng.";
+
+        if (setjmp(png_jmpbuf(png)))
+            throw nom + " - erreur d'écriture.";
+
+        png_init_io(png, fichier);
+        png_set_IHDR(png, info, largeur, hauteur, 8, PNG_COLOR_TYPE_RGB_ALPHA,
+                     PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT,
+                     PNG_FILTER_TYPE_DEFAULT);
+        png_write_info(png, info);
+    }
+
+    void ecrire_ligne(const png_rgba * ligne) {
+        if (setjmp(png_jmpbuf(png)))
+            throw nom + " - erreur d'écriture.";
+
+        png_write_row(png, (png_const_bytep)ligne);
+    }
+
+    /**
+     * Fin de l'image, après la dernière ligne
+     */
+    void fermer() {
+        if (setjmp(png_jmpbuf(png)))
+            throw nom + " - erreur d'écriture.";
+
+        png_write_end(png, NULL);
+        fclose(fichier);
+        fichier = NULL;
+    }
+
+private:
+    EcrivainPNG(const EcrivainPNG &);
+    EcrivainPNG & operator=(const EcrivainPNG &);
+
+    std::string nom;
+    FILE * fichier;
+    png_structp png;
+    png_infop info;
+};
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef IMAGE_HPP
+#define IMAGE_HPP
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#include "LePNG.hpp"
+
+
+/**
+ * Image planaire : un plan par canal, chaque plan entouré de marges et
+ * aligné sur 64 octets (une ligne de cache, un registre AVX-512)
+ *
+ * La colonne 0 de chaque ligne est alignée : la marge de gauche est
+ * arrondie au multiple de 64 octets et le stride en est un multiple. Les
+ * marges peuvent être remplies en miroir à partir d'une image RGBA
+ * entrelacée (LePNG ou tampon lodepng), comme ImageMarges.
+ *
+ * Une vue (vue()) partage la mémoire de l'image dont elle est issue, sans
+ * copie ; ses lignes ne sont alignées que si sa colonne d'origine l'est.
+ */
+template <typename T, int Canaux = 3>
+class Image
+{
+public:
+    static const int ALIGNEMENT = 64;  // Octets
+    static const int PAR_BLOC = ALIGNEMENT / sizeof(T);
+
+    Image(): l(0), h(0), m(0), pas(0), plan(0), origine(NULL) {}
+
+    /**
+     * Image de largeur x hauteur pixels entourée de marges, remplie de zéros
+     */
+    Image(int largeur, int hauteur, int marge = 0):
+        l(largeur), h(hauteur), m(marge)
+    {
+        const int marge_gauche = arrondir(m);
+        pas = arrondir(marge_gauche + l + m);
+        plan = (size_t)(h + 2 * m) * pas;
+
+        void * bloc = NULL;
+        if (posix_memalign(&bloc, ALIGNEMENT, Canaux * plan * sizeof(T)))
+            throw std::string("mémoire insuffisante pour l'image planaire.");
+        memoire = std::shared_ptr<T>((T *)bloc, free);
+        std::fill((T *)bloc, (T *)bloc + Canaux * plan, T());
+
+        origine = (T *)bloc + (size_t)m * pas + marge_gauche;
+    }
+
+    /**
+     * Copie planaire de l'image, marges en miroir
+     */
+    Image(const LePNG & rgba, int marge):
+        Image(rgba.largeur(), rgba.hauteur(), marge)
+    {
+        copier_depuis(rgba);
+    }
+
+    /**
+     * Copie des canaux d'un tampon RGBA entrelacé (tel que celui de
+     * lodepng) de largeur x hauteur pixels, au plus les dimensions de
+     * l'image, dans le coin supérieur gauche ; les marges autour de la
+     * région copiée sont remplies en miroir
+     */
+    void copier_depuis(const unsigned char * rgba, int largeur, int hauteur) {
+#pragma omp parallel for
+        for (int i = -m; i < hauteur + m; ++i) {
+            // Miroir haut-bas : -1 -> 0, hauteur -> hauteur - 1
+            const int source = (i < 0) ? -1 - i :
+                (i >= hauteur) ? 2 * hauteur - 1 - i : i;
+            const unsigned char * p = &rgba[(size_t)source * largeur * 4];
+
+            for (int c = 0; c < Canaux; ++c) {
+                T * x = ligne(c, i);
+                for (int j = 0; j < largeur; ++j)
+                    x[j] = p[j * 4 + c];
+
+                // Miroir gauche-droite
+                for (int j = 0; j < m; ++j) {
+                    x[-1 - j] = x[j];
+                    x[largeur + j] = x[largeur - 1 - j];
+                }
+            }
+        }
+    }
+
+    void copier_depuis(const LePNG & rgba) {
+        copier_depuis(&rgba[0].r, rgba.largeur(), rgba.hauteur());
+    }
+
+    /**
+     * Copie saturée des canaux de l'image vers un tampon RGBA entrelacé de
+     * mêmes dimensions ; les canaux suivants (alpha) ne sont pas modifiés
+     */
+    void copier_vers(unsigned char * rgba) const {
+#pragma omp parallel for
+        for (int i = 0; i < h; ++i) {
+            unsigned char * p = &rgba[(size_t)i * l * 4];
+            for (int c = 0; c < Canaux; ++c) {
+                const T * x = ligne(c, i);
+                for (int j = 0; j < l; ++j)
+                    p[j * 4 + c] = saturer(x[j]);
+            }
+        }
+    }
+
+    void copier_vers(LePNG & rgba) const {
+        copier_vers(&rgba[0].r);
+    }
+
+    /**
+     * Vue sans copie des hauteur x largeur pixels à partir de (i0, j0)
+     */
+    Image vue(int i0, int j0, int hauteur, int largeur) const {
+        Image v(*this);
+        v.origine = origine + (ptrdiff_t)i0 * pas + j0;
+        v.l = largeur;
+        v.h = hauteur;
+        v.m = 0;
+        return v;
+    }
+
+    /**
+     * Pixel (i, 0) du canal c ; les indices i et j peuvent déborder de la
+     * marge dans [-marge, hauteur + marge) x [-marge, largeur + marge)
+     */
+    inline T * ligne(int c, int i) {
+        return origine + c * plan + (ptrdiff_t)i * pas;
+    }
+    inline const T * ligne(int c, int i) const {
+        return origine + c * plan + (ptrdiff_t)i * pas;
+    }
+
+    inline T & operator()(int c, int i, int j) { return ligne(c, i)[j]; }
+    inline T operator()(int c, int i, int j) const { return ligne(c, i)[j]; }
+
+    inline int largeur() const { return l; }
+    inline int hauteur() const { return h; }
+    inline int marge() const { return m; }
+    inline int stride() const { return pas; }
+
+private:
+    static inline int arrondir(int n) {
+        return (n + PAR_BLOC - 1) / PAR_BLOC * PAR_BLOC;
+    }
+
+    int l, h, m;
+    int pas;         // Éléments par ligne, multiple de PAR_BLOC
+    size_t plan;     // Éléments par plan
+    T * origine;     // Pixel (0, 0) du canal 0
+    std::shared_ptr<T> memoire;
+};
+
+#endif
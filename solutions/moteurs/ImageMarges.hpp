@@ -0,0 +1,77 @@
+#ifndef IMAGEMARGES_HPP
+#define IMAGEMARGES_HPP
+
+#include <iostream>
+
+#include "LePNG.hpp"
+
+
+/**
+ * Copie de l'image originale entourée de marges en miroir, telle que
+ * construite par prod_conv() dans defi-mpi/convolution.cpp
+ */
+class ImageMarges: public LePNG
+{
+public:
+    ImageMarges(const LePNG & rgba, int marge_):
+        largeur_orig(rgba.largeur()), hauteur_orig(rgba.hauteur()),
+        marge(marge_),
+        marge_gauche((marge_ + 15) & ~15),  // Alignée sur 64o=16*4o
+        stride(marge_gauche + ((largeur_orig + marge_ + 15) & ~15))
+    {
+        std::cout << "  Marge réelle :  " << marge << std::endl;
+        std::cout << "  Marge alignée : " << marge_gauche << std::endl;
+        std::cout << "  Largeur totale alignée : " << stride
+            << " (= " << marge_gauche << " + " << largeur_orig << " + "
+            << stride - (marge_gauche + largeur_orig) << ")" << std::endl;
+
+        redimensionner(stride, marge + hauteur_orig + marge);
+        LePNG & im_temp = *this;
+
+        const int largeur = largeur_orig;
+        const int hauteur = hauteur_orig;
+
+        // Remplir les marges du haut et du bas
+        for (int i = 0; i < marge; ++i) {
+            for (int j = 0; j < largeur; ++j) {
+                im_temp[(marge - 1 - i) * stride + (marge_gauche + j)] =
+                    rgba[i * largeur + j];
+                im_temp[(marge + hauteur + i) * stride + (marge_gauche + j)] =
+                    rgba[(hauteur - 1 - i) * largeur + j];
+            }
+        }
+
+        // Copier l'image originale
+        for (int i = 0; i < hauteur; ++i) {
+            for (int j = 0; j < largeur; ++j) {
+                im_temp[(marge + i) * stride + (marge_gauche + j)] =
+                    rgba[i * largeur + j];
+            }
+        }
+
+        // Remplir les marges de gauche et de droite
+        for (png_uint_32 i = 0; i < im_temp.hauteur(); ++i) {
+            for (int j = 0; j < marge; ++j) {
+                im_temp[i * stride + (marge_gauche - 1 - j)] =
+                    im_temp[i * stride + (marge_gauche + j)];
+                im_temp[i * stride + (marge_gauche + largeur + j)] =
+                    im_temp[i * stride + (marge_gauche + largeur - 1 - j)];
+            }
+        }
+    }
+
+    /**
+     * Indice du pixel (i, j) de l'image originale dans la copie
+     */
+    inline size_type index(int i, int j) const {
+        return (marge + i) * stride + (marge_gauche + j);
+    }
+
+    const int largeur_orig;
+    const int hauteur_orig;
+    const int marge;
+    const int marge_gauche;
+    const int stride;
+};
+
+#endif
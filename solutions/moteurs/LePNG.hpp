@@ -0,0 +1,106 @@
+#ifndef LEPNG_HPP
+#define LEPNG_HPP
+
+#include <cstring>
+#include <png.h>
+#include <string>
+#include <vector>
+
+
+/**
+ * Enregistrement de 4 octets, un par canal de pixel RGBA
+ */
+typedef struct {
+    png_byte r;  // Rouge
+    png_byte g;  // Vert
+    png_byte b;  // Bleu
+    png_byte a;  // Alpha
+} png_rgba;
+
+
+/**
+ * Protection contre la saturation, puis conversion en octet (troncature)
+ */
+static inline png_byte saturer(double v)
+{
+    if (v < 0.) { v = 0.; } if (v > 255.) { v = 255.; }
+    return (png_byte)v;
+}
+
+
+/**
+ * Classe facilitant la lecture-écriture (Le) de fichiers PNG en RGBA
+ * https://sourceforge.net/p/libpng/code/ci/master/tree/example.c
+ * https://sourceforge.net/p/libpng/code/ci/master/tree/png.h
+ */
+class LePNG: public std::vector<png_rgba>
+{
+public:
+    LePNG() {
+        memset(&entete, 0, sizeof entete);
+
+        entete.format = PNG_FORMAT_RGBA;
+        entete.version = PNG_IMAGE_VERSION;
+    }
+
+    LePNG(const LePNG & autre): std::vector<png_rgba>(autre) {
+        memset(&entete, 0, sizeof entete);
+
+        entete.format = PNG_FORMAT_RGBA;
+        entete.version = PNG_IMAGE_VERSION;
+        entete.width = autre.entete.width;
+        entete.height = autre.entete.height;
+    }
+
+    virtual ~LePNG() {
+        png_image_free(&entete);
+    }
+
+    /**
+     * Modifier les dimensions de l'image
+     */
+    void redimensionner(png_uint_32 largeur, png_uint_32 hauteur) {
+        entete.width = largeur;
+        entete.height = hauteur;
+
+        resize(entete.width * entete.height);
+    }
+
+    /**
+     * Charger une image d'un fichier PNG - 4 canaux (Red, Green, Blue, Alpha)
+     */
+    void charger(const std::string & nom_fichier) {
+        if (!png_image_begin_read_from_file(&entete, nom_fichier.c_str()))
+            throw nom_fichier + " - " + entete.message;
+
+        resize(entete.width * entete.height);
+
+        if (!png_image_finish_read(&entete, NULL, data(), 0, NULL))
+            throw nom_fichier + " - " + entete.message;
+    }
+
+    /**
+     * Enregistrer le résultat dans un fichier PNG
+     */
+    void enregistrer(const std::string & nom_fichier) {
+        if (!png_image_write_to_file(
+                &entete, nom_fichier.c_str(), 0, data(), 0, NULL)) {
+            throw nom_fichier + " - " + entete.message;
+        }
+    }
+
+    inline png_uint_32 largeur() const { return entete.width; }
+    inline png_uint_32 hauteur() const { return entete.height; }
+
+    LePNG & operator=(const LePNG & autre) {
+        std::vector<png_rgba>::operator=(autre);
+        entete.width = autre.entete.width;
+        entete.height = autre.entete.height;
+        return *this;
+    }
+
+private:
+    png_image entete;
+};
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef MOTEURAXPY_HPP
+#define MOTEURAXPY_HPP
+
+#include <algorithm>
+
+#include "Image.hpp"
+#include "Noyau.hpp"
+
+
+/**
+ * Produit de convolution direct, coefficient par coefficient - écrase
+ * l'image originale
+ *
+ * La boucle sur les coefficients est à l'extérieur : pour chacun, une
+ * ligne d'entrée décalée est multipliée et accumulée (axpy) dans une ligne
+ * de sortie. La boucle interne parcourt la largeur de l'image, ce qui se
+ * vectorise entièrement quel que soit K.
+ */
+static void prod_conv_axpy(LePNG & rgba, const Noyau & filtre)
+{
+    // Segment de ligne accumulé en cache L1 (8 Ko par canal)
+    const int SEGMENT = 1024;
+
+    const int largeur = rgba.largeur();
+    const int hauteur = rgba.hauteur();
+    const int taille_filtre = filtre.largeur();
+    const int marge = (int)taille_filtre / 2;  // Type int (signé) nécessaire
+
+    const Image<double> im(rgba, marge);
+
+    std::cout << "Filtrage direct par axpy en cours ..." << std::endl;
+
+#pragma omp parallel
+    {
+        Image<double> acc(SEGMENT, 1);
+
+#pragma omp for
+        for (int i = 0; i < hauteur; ++i) {
+            for (int j0 = 0; j0 < largeur; j0 += SEGMENT) {
+                const int n = std::min(SEGMENT, largeur - j0);
+
+                double * acc_r = acc.ligne(0, 0);
+                double * acc_g = acc.ligne(1, 0);
+                double * acc_b = acc.ligne(2, 0);
+                std::fill(acc_r, acc_r + n, 0.);
+                std::fill(acc_g, acc_g + n, 0.);
+                std::fill(acc_b, acc_b + n, 0.);
+
+                // Acc[j] += Im[i+ii, j+jj] * Filtre[-ii, -jj], pour chaque
+                // coefficient (ii, jj) pris tour à tour
+                for (int ii = -marge; ii <= marge; ++ii) {
+                    for (int jj = -marge; jj <= marge; ++jj) {
+                        const double w = filtre[
+                            (marge - ii) * taille_filtre + (marge - jj)];
+                        const double * im_r = im.ligne(0, i + ii) + j0 + jj;
+                        const double * im_g = im.ligne(1, i + ii) + j0 + jj;
+                        const double * im_b = im.ligne(2, i + ii) + j0 + jj;
+
+#pragma omp simd
+                        for (int j = 0; j < n; ++j) {
+                            acc_r[j] += im_r[j] * w;
+                            acc_g[j] += im_g[j] * w;
+                            acc_b[j] += im_b[j] * w;
+                        }
+                    }
+                }
+
+                // Placer le résultat dans l'image originale
+                for (int j = 0; j < n; ++j) {
+                    rgba[i * largeur + j0 + j].r = saturer(acc_r[j]);
+                    rgba[i * largeur + j0 + j].g = saturer(acc_g[j]);
+                    rgba[i * largeur + j0 + j].b = saturer(acc_b[j]);
+                }
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef MOTEURBANQUE_HPP
+#define MOTEURBANQUE_HPP
+
+#include <algorithm>
+#include <vector>
+
+#include "Image.hpp"
+#include "Noyau.hpp"
+
+
+/**
+ * Banc de filtres : produit de convolution de la même image par plusieurs
+ * noyaux en un seul balayage - sorties[k] reçoit le résultat du noyau k
+ *
+ * Pour chaque tuile de sortie, la fenêtre d'entrée (tuile + marges du plus
+ * grand noyau, vue sur les plans de l'image) est chargée une seule fois en
+ * cache et y reste pendant que chaque noyau y accumule ses coefficients
+ * non nuls. Le trafic mémoire sur
+ * l'image ne croît donc pas avec le nombre de noyaux.
+ */
+static void prod_conv_banque(const LePNG & rgba,
+                             const std::vector<Noyau> & filtres,
+                             std::vector<LePNG> & sorties)
+{
+    const int TUILE_I = 32;
+    const int TUILE_J = 128;
+
+    const int largeur = rgba.largeur();
+    const int hauteur = rgba.hauteur();
+
+    int marge = 0;  // Type int (signé) nécessaire
+    for (size_t k = 0; k < filtres.size(); ++k)
+        marge = std::max(marge, (int)filtres[k].largeur() / 2);
+
+    const Image<double> im(rgba, marge);
+
+    std::cout << "Filtrage par banc de " << filtres.size()
+        << " noyaux en cours ..." << std::endl;
+
+    sorties.assign(filtres.size(), rgba);
+
+    const int tuiles_i = (hauteur + TUILE_I - 1) / TUILE_I;
+    const int tuiles_j = (largeur + TUILE_J - 1) / TUILE_J;
+
+#pragma omp parallel
+    {
+        // Accumulateurs d'une tuile, par canal
+        Image<double> acc(TUILE_J, TUILE_I);
+
+#pragma omp for collapse(2) schedule(dynamic)
+        for (int ti = 0; ti < tuiles_i; ++ti) {
+            for (int tj = 0; tj < tuiles_j; ++tj) {
+                const int i0 = ti * TUILE_I;
+                const int j0 = tj * TUILE_J;
+                const int ni = std::min(TUILE_I, hauteur - i0);
+                const int nj = std::min(TUILE_J, largeur - j0);
+
+                // Fenêtre[x, y] = Im[i0 + x, j0 + y], sans copie
+                const Image<double> fenetre = im.vue(i0, j0, ni, nj);
+
+                for (size_t k = 0; k < filtres.size(); ++k) {
+                    const std::vector<Coefficient> & coef =
+                        filtres[k].coefficients();
+
+                    for (int c = 0; c < 3; ++c) {
+                        for (int x = 0; x < ni; ++x)
+                            std::fill(acc.ligne(c, x), acc.ligne(c, x) + nj, 0.);
+
+                        for (size_t t = 0; t < coef.size(); ++t) {
+                            const double w = coef[t].poids;
+
+                            for (int x = 0; x < ni; ++x) {
+                                const double * f = fenetre.ligne(
+                                    c, x + coef[t].di) + coef[t].dj;
+                                double * a = acc.ligne(c, x);
+#pragma omp simd
+                                for (int y = 0; y < nj; ++y)
+                                    a[y] += f[y] * w;
+                            }
+                        }
+
+                        // Placer le résultat dans l'image du noyau k
+                        for (int x = 0; x < ni; ++x) {
+                            const double * a = acc.ligne(c, x);
+                            for (int y = 0; y < nj; ++y) {
+                                png_byte * p =
+                                    &sorties[k][(i0 + x) * largeur + j0 + y].r;
+                                p[c] = saturer(a[y]);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef MOTEURBLOCS_HPP
+#define MOTEURBLOCS_HPP
+
+#include <algorithm>
+#include <vector>
+
+#include "Image.hpp"
+#include "Noyau.hpp"
+
+
+/**
+ * Produit de convolution direct par blocs de registres et tuiles de cache
+ * - écrase l'image originale
+ *
+ * Chaque coefficient chargé sert à BLOC_I x BLOC_J pixels de sortie à la
+ * fois. Les colonnes sont découpées en tuiles dont la fenêtre d'entrée
+ * (K + BLOC_I - 1 lignes) tient dans le cache L2, et chaque tuile est
+ * parcourue de haut en bas pour réutiliser les K - 1 lignes communes.
+ */
+static void prod_conv_blocs(LePNG & rgba, const Noyau & filtre)
+{
+    const int BLOC_I = 4;
+    const int BLOC_J = 8;
+    const int CACHE_L2 = 256 * 1024;
+
+    const int largeur = rgba.largeur();
+    const int hauteur = rgba.hauteur();
+    const int taille_filtre = filtre.largeur();
+    const int marge = (int)taille_filtre / 2;  // Type int (signé) nécessaire
+
+    // Plans avec marges, complétés par des zéros jusqu'à des multiples
+    // entiers de blocs ; les pixels de sortie excédentaires sont ignorés
+    const int hauteur_blocs = (hauteur + BLOC_I - 1) / BLOC_I * BLOC_I;
+    const int largeur_blocs = (largeur + BLOC_J - 1) / BLOC_J * BLOC_J;
+
+    Image<double> plans(largeur_blocs, hauteur_blocs, marge);
+    plans.copier_depuis(rgba);
+    const int stride = plans.stride();
+
+    // Largeur des tuiles : une fenêtre de (K + BLOC_I - 1) lignes par canal
+    const int largeur_tuile = std::max(BLOC_J, std::min(largeur_blocs,
+        (CACHE_L2 / (int)sizeof(double) / (taille_filtre + BLOC_I - 1)
+         - 2 * marge) / BLOC_J * BLOC_J));
+
+    std::cout << "Filtrage direct par blocs " << BLOC_I << " x " << BLOC_J
+        << " en cours (tuiles de " << largeur_tuile << " colonnes) ..."
+        << std::endl;
+
+    // Noyau retourné : poids[ii * K + jj] = Filtre[-ii, -jj]
+    std::vector<double> poids(taille_filtre * taille_filtre);
+    for (int ii = 0; ii < taille_filtre; ++ii)
+        for (int jj = 0; jj < taille_filtre; ++jj)
+            poids[ii * taille_filtre + jj] = filtre[
+                (taille_filtre - 1 - ii) * taille_filtre
+                + (taille_filtre - 1 - jj)];
+
+    const int tuiles = (largeur_blocs + largeur_tuile - 1) / largeur_tuile;
+
+#pragma omp parallel for collapse(2) schedule(dynamic)
+    for (int c = 0; c < 3; ++c) {
+        for (int tuile = 0; tuile < tuiles; ++tuile) {
+            // Coin supérieur gauche de la fenêtre du pixel (0, 0)
+            const double * plan = plans.ligne(c, -marge) - marge;
+            const int j_debut = tuile * largeur_tuile;
+            const int j_fin = std::min(largeur_blocs, j_debut + largeur_tuile);
+
+            for (int i0 = 0; i0 < hauteur_blocs; i0 += BLOC_I) {
+                for (int j0 = j_debut; j0 < j_fin; j0 += BLOC_J) {
+                    double acc[BLOC_I][BLOC_J] = {};
+
+                    for (int ii = 0; ii < taille_filtre; ++ii) {
+                        for (int jj = 0; jj < taille_filtre; ++jj) {
+                            const double w = poids[ii * taille_filtre + jj];
+                            const double * im =
+                                plan + (i0 + ii) * stride + (j0 + jj);
+
+                            for (int bi = 0; bi < BLOC_I; ++bi) {
+#pragma omp simd
+                                for (int bj = 0; bj < BLOC_J; ++bj)
+                                    acc[bi][bj] += im[bi * stride + bj] * w;
+                            }
+                        }
+                    }
+
+                    // Placer le résultat dans l'image originale
+                    for (int bi = 0; bi < BLOC_I && i0 + bi < hauteur; ++bi) {
+                        for (int bj = 0; bj < BLOC_J && j0 + bj < largeur;
+                                ++bj) {
+                            png_byte * p = &rgba[
+                                (i0 + bi) * largeur + (j0 + bj)].r;
+                            p[c] = saturer(acc[bi][bj]);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+#endif
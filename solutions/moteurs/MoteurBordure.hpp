@@ -0,0 +1,118 @@
+#ifndef MOTEURBORDURE_HPP
+#define MOTEURBORDURE_HPP
+
+#include <algorithm>
+#include <vector>
+
+#include "Bordure.hpp"
+#include "Image.hpp"
+#include "MoteurOctets.hpp"
+#include "Noyau.hpp"
+
+
+/**
+ * Produit de convolution sans copie avec marges, les bords étant traités
+ * selon une politique choisie à l'exécution - écrase l'image originale
+ *
+ * L'intérieur de l'image, où le noyau ne déborde pas, est calculé sans
+ * aucune vérification d'indice par le parcours de prod_conv_octets(). Seules
+ * les bandes de marge pixels le long des bords lisent leurs voisins par
+ * remapper(). La copie de travail est un plan d'octets par canal, sans
+ * marges.
+ */
+static void prod_conv_bordure(LePNG & rgba, const Noyau & filtre,
+                              PolitiqueBord politique, double constante = 0.)
+{
+    const int largeur = rgba.largeur();
+    const int hauteur = rgba.hauteur();
+    const int taille_filtre = filtre.largeur();
+    const int marge = (int)taille_filtre / 2;  // Type int (signé) nécessaire
+
+    const JeuInstructions jeu = detecter_jeu_instructions();
+    const AxpyOctets axpy = choisir_axpy_octets(jeu);
+
+    const Image<png_byte> im(rgba, 0);
+
+    std::cout << "Filtrage avec bords " << NOMS_BORDS[politique] << " ("
+        << NOMS_JEUX[jeu] << ") en cours ..." << std::endl;
+
+    // Ligne et colonne lues pour les indices -marge .. n + marge - 1
+    std::vector<int> lig(hauteur + 2 * marge), col(largeur + 2 * marge);
+    for (int x = 0; x < hauteur + 2 * marge; ++x)
+        lig[x] = remapper(x - marge, hauteur, politique);
+    for (int y = 0; y < largeur + 2 * marge; ++y)
+        col[y] = remapper(y - marge, largeur, politique);
+
+    // Colonnes intérieures [j_debut, j_fin), sans débordement du noyau
+    const int j_debut = std::min(marge, largeur);
+    const int j_fin = std::max(j_debut, largeur - marge);
+
+    std::vector<float> poids(filtre.begin(), filtre.end());
+    const float valeur = constante;
+
+#pragma omp parallel
+    {
+        std::vector<float> acc(largeur);
+
+#pragma omp for schedule(dynamic)
+        for (int i = 0; i < hauteur; ++i) {
+            const bool bord_i = (i < marge) || (i >= hauteur - marge);
+
+            // Pixels de bord laissés tels quels
+            if (politique == BORD_ORIGINAL && bord_i)
+                continue;
+
+            for (int c = 0; c < 3; ++c) {
+                // Intérieur : axpy sans vérification
+                if (!bord_i && j_fin > j_debut) {
+                    std::fill(&acc[j_debut], &acc[0] + j_fin, 0.f);
+
+                    for (int ii = -marge; ii <= marge; ++ii) {
+                        const png_byte * x = im.ligne(c, i + ii);
+
+                        for (int jj = -marge; jj <= marge; ++jj) {
+                            const float w = poids[
+                                (marge - ii) * taille_filtre + (marge - jj)];
+                            if (w != 0.f)
+                                axpy(&acc[j_debut], x + j_debut + jj, w,
+                                     j_fin - j_debut);
+                        }
+                    }
+                }
+
+                // Bords : toute la ligne, ou les bandes gauche et droite
+                for (int j = 0; j < largeur; ++j) {
+                    if (!bord_i && j == j_debut)
+                        j = j_fin;
+                    if (j >= largeur)
+                        break;
+                    if (politique == BORD_ORIGINAL &&
+                            (bord_i || j < j_debut || j >= j_fin)) {
+                        acc[j] = im(c, i, j);
+                        continue;
+                    }
+
+                    float v = 0.f;
+                    for (int ii = -marge; ii <= marge; ++ii) {
+                        const int l = lig[marge + i + ii];
+                        const png_byte * x = (l < 0) ? NULL : im.ligne(c, l);
+
+                        for (int jj = -marge; jj <= marge; ++jj) {
+                            const int k = col[marge + j + jj];
+                            const float p = (x && k >= 0) ? x[k] : valeur;
+                            v += p * poids[
+                                (marge - ii) * taille_filtre + (marge - jj)];
+                        }
+                    }
+                    acc[j] = v;
+                }
+
+                // Placer le résultat dans l'image originale
+                for (int j = 0; j < largeur; ++j)
+                    (&rgba[i * largeur + j].r)[c] = saturer(acc[j]);
+            }
+        }
+    }
+}
+
+#endif
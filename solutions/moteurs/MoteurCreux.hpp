@@ -0,0 +1,77 @@
+#ifndef MOTEURCREUX_HPP
+#define MOTEURCREUX_HPP
+
+#include <algorithm>
+#include <vector>
+
+#include "Image.hpp"
+#include "Noyau.hpp"
+
+
+/**
+ * Produit de convolution limité aux coefficients non nuls du noyau
+ * (matrice creuse) - écrase l'image originale
+ *
+ * Même parcours que prod_conv_axpy(), mais sur Noyau::coefficients() : le
+ * coût est proportionnel au nombre de coefficients retenus plutôt qu'à K^2.
+ */
+static void prod_conv_creux(LePNG & rgba, const Noyau & filtre)
+{
+    const int SEGMENT = 1024;
+
+    const int largeur = rgba.largeur();
+    const int hauteur = rgba.hauteur();
+    const int taille_filtre = filtre.largeur();
+    const int marge = (int)taille_filtre / 2;  // Type int (signé) nécessaire
+    const std::vector<Coefficient> & coef = filtre.coefficients();
+
+    const Image<double> im(rgba, marge);
+
+    std::cout << "Filtrage creux en cours (" << coef.size() << " sur "
+        << taille_filtre * taille_filtre << " coefficients, écart maximal "
+        << filtre.ecart_coefficients() << ") ..." << std::endl;
+
+#pragma omp parallel
+    {
+        Image<double> acc(SEGMENT, 1);
+
+#pragma omp for
+        for (int i = 0; i < hauteur; ++i) {
+            for (int j0 = 0; j0 < largeur; j0 += SEGMENT) {
+                const int n = std::min(SEGMENT, largeur - j0);
+
+                double * acc_r = acc.ligne(0, 0);
+                double * acc_g = acc.ligne(1, 0);
+                double * acc_b = acc.ligne(2, 0);
+                std::fill(acc_r, acc_r + n, 0.);
+                std::fill(acc_g, acc_g + n, 0.);
+                std::fill(acc_b, acc_b + n, 0.);
+
+                for (size_t k = 0; k < coef.size(); ++k) {
+                    const int ligne = i + coef[k].di;
+                    const int colonne = j0 + coef[k].dj;
+                    const double w = coef[k].poids;
+                    const double * im_r = im.ligne(0, ligne) + colonne;
+                    const double * im_g = im.ligne(1, ligne) + colonne;
+                    const double * im_b = im.ligne(2, ligne) + colonne;
+
+#pragma omp simd
+                    for (int j = 0; j < n; ++j) {
+                        acc_r[j] += im_r[j] * w;
+                        acc_g[j] += im_g[j] * w;
+                        acc_b[j] += im_b[j] * w;
+                    }
+                }
+
+                // Placer le résultat dans l'image originale
+                for (int j = 0; j < n; ++j) {
+                    rgba[i * largeur + j0 + j].r = saturer(acc_r[j]);
+                    rgba[i * largeur + j0 + j].g = saturer(acc_g[j]);
+                    rgba[i * largeur + j0 + j].b = saturer(acc_b[j]);
+                }
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,187 @@
+#ifndef MOTEURDECIMATION_HPP
+#define MOTEURDECIMATION_HPP
+
+#include <vector>
+
+#include "Image.hpp"
+#include "ImageMarges.hpp"
+#include "Noyau.hpp"
+
+
+/**
+ * Dimension d'un axe de n pixels décimé d'un pas donné : positions
+ * 0, pas, 2 * pas, ...
+ */
+static inline int taille_decimee(int n, int pas)
+{
+    return (n + pas - 1) / pas;
+}
+
+
+/**
+ * Produit de convolution direct évalué aux seules lignes et colonnes
+ * multiples de pas - remplace l'image originale par le résultat décimé,
+ * identique à un produit direct complet suivi d'un sous-échantillonnage
+ */
+static void prod_conv_decime_direct(LePNG & rgba, const Noyau & filtre,
+                                    int pas)
+{
+    const int largeur = rgba.largeur();
+    const int hauteur = rgba.hauteur();
+    const int taille_filtre = filtre.largeur();
+    const int marge = (int)taille_filtre / 2;  // Type int (signé) nécessaire
+    const int largeur_d = taille_decimee(largeur, pas);
+    const int hauteur_d = taille_decimee(hauteur, pas);
+
+    const ImageMarges im_temp(rgba, marge);
+
+    std::cout << "Filtrage direct décimé (pas " << pas << ") en cours ..."
+        << std::endl;
+
+    rgba.redimensionner(largeur_d, hauteur_d);
+
+#pragma omp parallel for
+    for (int id = 0; id < hauteur_d; ++id) {
+        for (int jd = 0; jd < largeur_d; ++jd) {
+            const int i = id * pas;
+            const int j = jd * pas;
+            double r = 0.;
+            double g = 0.;
+            double b = 0.;
+
+            for (int ii = -marge; ii <= marge; ++ii) {
+                for (int jj = -marge; jj <= marge; ++jj) {
+                    const LePNG::size_type index_im =
+                        im_temp.index(i + ii, j + jj);
+                    const Noyau::size_type index_filt =
+                        (marge - ii) * taille_filtre + (marge - jj);
+
+                    r += (double)im_temp[index_im].r * filtre[index_filt];
+                    g += (double)im_temp[index_im].g * filtre[index_filt];
+                    b += (double)im_temp[index_im].b * filtre[index_filt];
+                }
+            }
+
+            // Le canal alpha est celui du pixel échantillonné
+            png_rgba & p = rgba[id * largeur_d + jd];
+            p = im_temp[im_temp.index(i, j)];
+            p.r = saturer(r);
+            p.g = saturer(g);
+            p.b = saturer(b);
+        }
+    }
+}
+
+
+/**
+ * Produit de convolution séparable décimé : la passe horizontale n'est
+ * évaluée qu'aux colonnes multiples de pas, la passe verticale qu'aux
+ * lignes multiples de pas - remplace l'image originale par le résultat
+ */
+static void prod_conv_decime_separable(LePNG & rgba, const Noyau & filtre,
+                                       int pas)
+{
+    const int largeur = rgba.largeur();
+    const int hauteur = rgba.hauteur();
+    const int taille_filtre = filtre.largeur();
+    const int marge = (int)taille_filtre / 2;  // Type int (signé) nécessaire
+    const int largeur_d = taille_decimee(largeur, pas);
+    const int hauteur_d = taille_decimee(hauteur, pas);
+
+    const Image<png_byte, 4> im(rgba, marge);
+
+    std::cout << "Filtrage séparable décimé (pas " << pas << ", "
+        << filtre.rang() << " terme(s)) en cours ..." << std::endl;
+
+    // Passe horizontale aux colonnes retenues, marges du haut et du bas
+    // comprises ; somme des passes verticales aux lignes retenues
+    Image<double> horiz(largeur_d, hauteur + 2 * marge);
+    Image<double> somme(largeur_d, hauteur_d);
+
+    for (Noyau::size_type k = 0; k < filtre.rang(); ++k) {
+        const std::vector<double> & ligne = filtre.ligne(k);
+        const std::vector<double> & colonne = filtre.colonne(k);
+
+        // H[i, jd] = Sum_jj(Im[i, jd * pas + jj] * Ligne[-jj])
+#pragma omp parallel for
+        for (int i = 0; i < hauteur + 2 * marge; ++i) {
+            for (int c = 0; c < 3; ++c) {
+                const png_byte * lig = im.ligne(c, i - marge);
+                double * h = horiz.ligne(c, i);
+
+                for (int jd = 0; jd < largeur_d; ++jd) {
+                    double v = 0.;
+
+                    for (int jj = -marge; jj <= marge; ++jj)
+                        v += lig[jd * pas + jj] * ligne[marge - jj];
+
+                    h[jd] = v;
+                }
+            }
+        }
+
+        // S[id, jd] += Sum_ii(H[id * pas + ii, jd] * Colonne[-ii])
+#pragma omp parallel for
+        for (int id = 0; id < hauteur_d; ++id) {
+            double * acc_r = somme.ligne(0, id);
+            double * acc_g = somme.ligne(1, id);
+            double * acc_b = somme.ligne(2, id);
+
+            for (int ii = -marge; ii <= marge; ++ii) {
+                const double * h_r = horiz.ligne(0, marge + id * pas + ii);
+                const double * h_g = horiz.ligne(1, marge + id * pas + ii);
+                const double * h_b = horiz.ligne(2, marge + id * pas + ii);
+                const double poids = colonne[marge - ii];
+
+#pragma omp simd
+                for (int jd = 0; jd < largeur_d; ++jd) {
+                    acc_r[jd] += h_r[jd] * poids;
+                    acc_g[jd] += h_g[jd] * poids;
+                    acc_b[jd] += h_b[jd] * poids;
+                }
+            }
+        }
+    }
+
+    rgba.redimensionner(largeur_d, hauteur_d);
+
+    // Placer le résultat ; le canal alpha est celui du pixel échantillonné
+#pragma omp parallel for
+    for (int id = 0; id < hauteur_d; ++id) {
+        for (int jd = 0; jd < largeur_d; ++jd)
+            rgba[id * largeur_d + jd].a = im(3, id * pas, jd * pas);
+    }
+    somme.copier_vers(rgba);
+}
+
+
+/**
+ * Pyramide gaussienne : niveaux[0] est l'image originale, niveaux[n] le
+ * niveau n-1 filtré puis décimé d'un pas de 2. Chaque niveau sert
+ * directement d'entrée au suivant, sans passer par un fichier PNG ; le
+ * moteur séparable est utilisé si le noyau s'y prête et si separable est
+ * vrai, sinon le moteur direct.
+ */
+static void construire_pyramide(const LePNG & rgba, const Noyau & filtre,
+                                int nb_niveaux, std::vector<LePNG> & niveaux,
+                                bool separable = true)
+{
+    const int marge = (int)filtre.largeur() / 2;
+
+    niveaux.assign(1, rgba);
+
+    for (int n = 1; n < nb_niveaux; ++n) {
+        // Le miroir des marges exige un niveau plus grand que la marge
+        if ((int)niveaux[n - 1].largeur() <= marge ||
+            (int)niveaux[n - 1].hauteur() <= marge)
+            break;
+
+        niveaux.push_back(niveaux[n - 1]);
+        if (separable && filtre.rang() > 0)
+            prod_conv_decime_separable(niveaux[n], filtre, 2);
+        else
+            prod_conv_decime_direct(niveaux[n], filtre, 2);
+    }
+}
+
+#endif
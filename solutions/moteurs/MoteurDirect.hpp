@@ -0,0 +1,52 @@
+#ifndef MOTEURDIRECT_HPP
+#define MOTEURDIRECT_HPP
+
+#include "ImageMarges.hpp"
+#include "Noyau.hpp"
+
+
+/**
+ * Produit de convolution direct (référence) - écrase l'image originale
+ * https://fr.wikipedia.org/wiki/Produit_de_convolution
+ */
+static void prod_conv_direct(LePNG & rgba, const Noyau & filtre)
+{
+    const int largeur = rgba.largeur();
+    const int hauteur = rgba.hauteur();
+    const int taille_filtre = filtre.largeur();
+    const int marge = (int)taille_filtre / 2;  // Type int (signé) nécessaire
+
+    const ImageMarges im_temp(rgba, marge);
+
+    std::cout << "Filtrage direct en cours ..." << std::endl;
+
+    // Prod_conv[i, j] = Sum_ii(Sum_jj(Im[i+ii, j+jj] * Filtre[-ii, -jj]))
+#pragma omp parallel for
+    for (int i = 0; i < hauteur; ++i) {
+        for (int j = 0; j < largeur; ++j) {
+            double r = 0.;
+            double g = 0.;
+            double b = 0.;
+
+            for (int ii = -marge; ii <= marge; ++ii) {
+                for (int jj = -marge; jj <= marge; ++jj) {
+                    const LePNG::size_type index_im =
+                        im_temp.index(i + ii, j + jj);
+                    const Noyau::size_type index_filt =
+                        (marge - ii) * taille_filtre + (marge - jj);
+
+                    r += (double)im_temp[index_im].r * filtre[index_filt];
+                    g += (double)im_temp[index_im].g * filtre[index_filt];
+                    b += (double)im_temp[index_im].b * filtre[index_filt];
+                }
+            }
+
+            // Placer le résultat dans l'image originale
+            rgba[i * largeur + j].r = saturer(r);
+            rgba[i * largeur + j].g = saturer(g);
+            rgba[i * largeur + j].b = saturer(b);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,427 @@
+#ifndef MOTEURENTIER_HPP
+#define MOTEURENTIER_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Image.hpp"
+#include "MoteurSIMD.hpp"
+#include "Noyau.hpp"
+
+
+/**
+ * Noyau quantifié en virgule fixe : Filtre[i] ~= valeurs[i] / 2^decalage
+ *
+ * Le décalage est le plus grand, de 30 à 0, tel que chaque coefficient
+ * tienne sur 16 bits et que 255 * Sum(|valeurs|) plus l'arrondi tienne sur
+ * 32 bits signés, ce qui exclut tout débordement de l'accumulateur ; sans
+ * décalage possible, le constructeur lance une std::string.
+ */
+struct NoyauEntier
+{
+    explicit NoyauEntier(const Noyau & filtre): valeurs(filtre.size()) {
+        double max_abs = 0.;
+        for (Noyau::size_type i = 0; i < filtre.size(); ++i)
+            max_abs = std::max(max_abs, std::fabs(filtre[i]));
+
+        for (decalage = 30; ; --decalage) {
+            if (decalage < 0)
+                throw std::string("noyau non représentable en virgule fixe"
+                    " (coefficient hors de [-32767, 32767] ou accumulateur 32 bits"
+                    " insuffisant).");
+
+            const double echelle = std::ldexp(1., decalage);
+            if (max_abs * echelle > 32767.)
+                continue;
+
+            int64_t somme = 0;
+            for (Noyau::size_type i = 0; i < filtre.size(); ++i) {
+                valeurs[i] = (int16_t)std::lround(filtre[i] * echelle);
+                somme += std::abs((int)valeurs[i]);
+            }
+            arrondi = (decalage > 0) ? 1 << (decalage - 1) : 0;
+            if (255 * somme + arrondi <= INT32_MAX)
+                break;
+        }
+
+        // Borne de l'écart avec le calcul en double, en niveaux de gris,
+        // avant l'arrondi final
+        ecart_max = 0.;
+        for (Noyau::size_type i = 0; i < filtre.size(); ++i)
+            ecart_max += 255. * std::fabs(
+                filtre[i] - std::ldexp((double)valeurs[i], -decalage));
+    }
+
+    std::vector<int16_t> valeurs;
+    int decalage;
+    int32_t arrondi;  // 2^(decalage - 1), pour arrondir au plus proche
+    double ecart_max;
+};
+
+
+/**
+ * Un canal de n pixels de sortie, calculés d'un bloc dans les registres :
+ * Sortie[j] = sat((arrondi + Sum_l Sum_q Paires[l][q] . (Lignes[l][j + 2q],
+ * Lignes[l][j + 2q + 1])) >> decalage), chaque paire contenant deux
+ * coefficients voisins sur 16 bits (le premier en bas). Pour K impair, la
+ * dernière paire a un second coefficient nul et relit le même pixel, sans
+ * lire au-delà de la marge.
+ */
+typedef void (*SegmentEntier)(png_byte * sortie,
+                              const png_byte * const * lignes,
+                              const int32_t * paires, int nb_lignes, int k,
+                              int n, int decalage, int32_t arrondi);
+
+static inline png_byte saturer_entier(int32_t v)
+{
+    return (png_byte)std::min(std::max(v, 0), 255);
+}
+
+/**
+ * Pixels [debut, n) d'un segment, un à un ; fin des versions vectorielles
+ */
+static void segment_entier_reste(png_byte * sortie,
+                                 const png_byte * const * lignes,
+                                 const int32_t * paires, int nb_lignes, int k,
+                                 int debut, int n, int decalage,
+                                 int32_t arrondi)
+{
+    const int nb_paires = (k + 1) / 2;
+
+    for (int j = debut; j < n; ++j) {
+        int32_t acc = arrondi;
+        for (int l = 0; l < nb_lignes; ++l) {
+            const png_byte * x = lignes[l] + j;
+            const int32_t * p = paires + l * nb_paires;
+            for (int q = 0; q < nb_paires; ++q) {
+                acc += x[2 * q] * (int16_t)(p[q] & 0xFFFF)
+                    + x[std::min(2 * q + 1, k - 1)] * (int16_t)(p[q] >> 16);
+            }
+        }
+        sortie[j] = saturer_entier(acc >> decalage);
+    }
+}
+
+static void segment_entier_scalaire(png_byte * sortie,
+                                    const png_byte * const * lignes,
+                                    const int32_t * paires, int nb_lignes,
+                                    int k, int n, int decalage, int32_t arrondi)
+{
+    segment_entier_reste(sortie, lignes, paires, nb_lignes, k, 0, n,
+                         decalage, arrondi);
+}
+
+#ifdef MOTEURSIMD_X86
+/**
+ * 16 pixels par bloc : octets des deux pixels d'une paire entrelacés
+ * (punpcklbw), étendus à 16 bits, puis pmaddwd - deux produits 16 bits
+ * additionnés sur 32 bits ; résultat ramené à 8 bits par packssdw et
+ * packuswb, qui saturent
+ */
+__attribute__((target("sse4.2")))
+static void segment_entier_sse42(png_byte * sortie,
+                                 const png_byte * const * lignes,
+                                 const int32_t * paires, int nb_lignes, int k,
+                                 int n, int decalage, int32_t arrondi)
+{
+    const int nb_paires = (k + 1) / 2;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i va = _mm_set1_epi32(arrondi);
+    const __m128i vd = _mm_cvtsi32_si128(decalage);
+    int j = 0;
+
+    for (; j + 16 <= n; j += 16) {
+        __m128i s0 = va, s1 = va, s2 = va, s3 = va;
+
+        for (int l = 0; l < nb_lignes; ++l) {
+            const png_byte * x = lignes[l] + j;
+            const int32_t * p = paires + l * nb_paires;
+
+            for (int q = 0; q < nb_paires; ++q) {
+                const __m128i w = _mm_set1_epi32(p[q]);
+                const __m128i a = _mm_loadu_si128((const __m128i *)(x + 2 * q));
+                const __m128i b = _mm_loadu_si128(
+                    (const __m128i *)(x + std::min(2 * q + 1, k - 1)));
+                const __m128i lo = _mm_unpacklo_epi8(a, b);
+                const __m128i hi = _mm_unpackhi_epi8(a, b);
+
+                s0 = _mm_add_epi32(s0, _mm_madd_epi16(_mm_unpacklo_epi8(lo, zero), w));
+                s1 = _mm_add_epi32(s1, _mm_madd_epi16(_mm_unpackhi_epi8(lo, zero), w));
+                s2 = _mm_add_epi32(s2, _mm_madd_epi16(_mm_unpacklo_epi8(hi, zero), w));
+                s3 = _mm_add_epi32(s3, _mm_madd_epi16(_mm_unpackhi_epi8(hi, zero), w));
+            }
+        }
+
+        s0 = _mm_sra_epi32(s0, vd);
+        s1 = _mm_sra_epi32(s1, vd);
+        s2 = _mm_sra_epi32(s2, vd);
+        s3 = _mm_sra_epi32(s3, vd);
+        _mm_storeu_si128((__m128i *)(sortie + j), _mm_packus_epi16(
+            _mm_packs_epi32(s0, s1), _mm_packs_epi32(s2, s3)));
+    }
+
+    segment_entier_reste(sortie, lignes, paires, nb_lignes, k, j, n,
+                         decalage, arrondi);
+}
+
+/**
+ * 32 pixels par bloc, en deux moitiés de 16 : paires entrelacées sur 128
+ * bits puis étendues à 16 bits sur 256 (vpmovzxbw), vpmaddwd ; packssdw
+ * opère par moitié de registre, d'où la permutation avant packuswb
+ */
+__attribute__((target("avx2,fma")))
+static void segment_entier_avx2(png_byte * sortie,
+                                const png_byte * const * lignes,
+                                const int32_t * paires, int nb_lignes, int k,
+                                int n, int decalage, int32_t arrondi)
+{
+    const int nb_paires = (k + 1) / 2;
+    const __m256i va = _mm256_set1_epi32(arrondi);
+    const __m128i vd = _mm_cvtsi32_si128(decalage);
+    int j = 0;
+
+    for (; j + 32 <= n; j += 32) {
+        __m256i s0 = va, s1 = va, s2 = va, s3 = va;
+
+        for (int l = 0; l < nb_lignes; ++l) {
+            const png_byte * x = lignes[l] + j;
+            const int32_t * p = paires + l * nb_paires;
+
+            for (int q = 0; q < nb_paires; ++q) {
+                const __m256i w = _mm256_set1_epi32(p[q]);
+                const png_byte * xa = x + 2 * q;
+                const png_byte * xb = x + std::min(2 * q + 1, k - 1);
+                const __m128i a0 = _mm_loadu_si128((const __m128i *)xa);
+                const __m128i b0 = _mm_loadu_si128((const __m128i *)xb);
+                const __m128i a1 = _mm_loadu_si128((const __m128i *)(xa + 16));
+                const __m128i b1 = _mm_loadu_si128((const __m128i *)(xb + 16));
+
+                s0 = _mm256_add_epi32(s0, _mm256_madd_epi16(
+                    _mm256_cvtepu8_epi16(_mm_unpacklo_epi8(a0, b0)), w));
+                s1 = _mm256_add_epi32(s1, _mm256_madd_epi16(
+                    _mm256_cvtepu8_epi16(_mm_unpackhi_epi8(a0, b0)), w));
+                s2 = _mm256_add_epi32(s2, _mm256_madd_epi16(
+                    _mm256_cvtepu8_epi16(_mm_unpacklo_epi8(a1, b1)), w));
+                s3 = _mm256_add_epi32(s3, _mm256_madd_epi16(
+                    _mm256_cvtepu8_epi16(_mm_unpackhi_epi8(a1, b1)), w));
+            }
+        }
+
+        // packs : [0-3, 8-11 | 4-7, 12-15] -> 0-15 par vpermq
+        const __m256i p0 = _mm256_permute4x64_epi64(_mm256_packs_epi32(
+            _mm256_sra_epi32(s0, vd), _mm256_sra_epi32(s1, vd)), 0xD8);
+        const __m256i p1 = _mm256_permute4x64_epi64(_mm256_packs_epi32(
+            _mm256_sra_epi32(s2, vd), _mm256_sra_epi32(s3, vd)), 0xD8);
+        _mm256_storeu_si256((__m256i *)(sortie + j),
+            _mm256_permute4x64_epi64(_mm256_packus_epi16(p0, p1), 0xD8));
+    }
+
+    segment_entier_reste(sortie, lignes, paires, nb_lignes, k, j, n,
+                         decalage, arrondi);
+}
+
+/**
+ * 32 pixels par bloc : paires entrelacées par moitié de registre 256 bits,
+ * donc pixels 0-7 et 16-23 dans le premier accumulateur ; vpmovusdb,
+ * masqué par le signe, sature à [0, 255] et les moitiés sont remises en
+ * ordre
+ */
+__attribute__((target("avx512f,avx512bw")))
+static void segment_entier_avx512(png_byte * sortie,
+                                  const png_byte * const * lignes,
+                                  const int32_t * paires, int nb_lignes, int k,
+                                  int n, int decalage, int32_t arrondi)
+{
+    const int nb_paires = (k + 1) / 2;
+    const __m512i va = _mm512_set1_epi32(arrondi);
+    const __m128i vd = _mm_cvtsi32_si128(decalage);
+    const __m512i zero = _mm512_setzero_si512();
+    int j = 0;
+
+    for (; j + 32 <= n; j += 32) {
+        __m512i s0 = va, s1 = va;
+
+        for (int l = 0; l < nb_lignes; ++l) {
+            const png_byte * x = lignes[l] + j;
+            const int32_t * p = paires + l * nb_paires;
+
+            for (int q = 0; q < nb_paires; ++q) {
+                const __m512i w = _mm512_set1_epi32(p[q]);
+                const __m256i a = _mm256_loadu_si256((const __m256i *)(x + 2 * q));
+                const __m256i b = _mm256_loadu_si256(
+                    (const __m256i *)(x + std::min(2 * q + 1, k - 1)));
+
+                s0 = _mm512_add_epi32(s0, _mm512_madd_epi16(
+                    _mm512_cvtepu8_epi16(_mm256_unpacklo_epi8(a, b)), w));
+                s1 = _mm512_add_epi32(s1, _mm512_madd_epi16(
+                    _mm512_cvtepu8_epi16(_mm256_unpackhi_epi8(a, b)), w));
+            }
+        }
+
+        s0 = _mm512_maskz_sra_epi32(0xFFFF, s0, vd);
+        s1 = _mm512_maskz_sra_epi32(0xFFFF, s1, vd);
+        const __m128i o0 = _mm512_maskz_cvtusepi32_epi8(
+            _mm512_cmpgt_epi32_mask(s0, zero), s0);
+        const __m128i o1 = _mm512_maskz_cvtusepi32_epi8(
+            _mm512_cmpgt_epi32_mask(s1, zero), s1);
+        _mm_storeu_si128((__m128i *)(sortie + j), _mm_unpacklo_epi64(o0, o1));
+        _mm_storeu_si128((__m128i *)(sortie + j + 16),
+                         _mm_unpackhi_epi64(o0, o1));
+    }
+
+    segment_entier_reste(sortie, lignes, paires, nb_lignes, k, j, n,
+                         decalage, arrondi);
+}
+#endif
+
+
+/**
+ * Version du jeu d'instructions ; AVX-512 demande aussi AVX-512BW, sinon
+ * jeu redescend à AVX2
+ */
+static SegmentEntier choisir_segment_entier(JeuInstructions & jeu)
+{
+#ifdef MOTEURSIMD_X86
+    if (jeu == AVX512 && !__builtin_cpu_supports("avx512bw"))
+        jeu = AVX2;
+
+    switch (jeu) {
+        case AVX512: return segment_entier_avx512;
+        case AVX2: return segment_entier_avx2;
+        case SSE42: return segment_entier_sse42;
+        default: break;
+    }
+#endif
+    return segment_entier_scalaire;
+}
+
+
+/**
+ * Sortie[0..n) = canaux R, G et B, entrelacés dans l'image RGBA sans
+ * toucher à l'alpha
+ */
+static void entrelacer_rgb(png_rgba * sortie, const png_byte * r,
+                           const png_byte * g, const png_byte * b, int n)
+{
+    int j = 0;
+
+#ifdef MOTEURSIMD_X86
+    const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; j + 16 <= n; j += 16) {
+        const __m128i vr = _mm_loadu_si128((const __m128i *)(r + j));
+        const __m128i vg = _mm_loadu_si128((const __m128i *)(g + j));
+        const __m128i vb = _mm_loadu_si128((const __m128i *)(b + j));
+        const __m128i rg_lo = _mm_unpacklo_epi8(vr, vg);
+        const __m128i rg_hi = _mm_unpackhi_epi8(vr, vg);
+        const __m128i b0_lo = _mm_unpacklo_epi8(vb, zero);
+        const __m128i b0_hi = _mm_unpackhi_epi8(vb, zero);
+        const __m128i rgb0[4] = {
+            _mm_unpacklo_epi16(rg_lo, b0_lo), _mm_unpackhi_epi16(rg_lo, b0_lo),
+            _mm_unpacklo_epi16(rg_hi, b0_hi), _mm_unpackhi_epi16(rg_hi, b0_hi)
+        };
+
+        for (int t = 0; t < 4; ++t) {
+            __m128i * p = (__m128i *)(sortie + j + 4 * t);
+            _mm_storeu_si128(p, _mm_or_si128(rgb0[t],
+                _mm_and_si128(_mm_loadu_si128(p), alpha)));
+        }
+    }
+#endif
+
+    for (; j < n; ++j) {
+        sortie[j].r = r[j];
+        sortie[j].g = g[j];
+        sortie[j].b = b[j];
+    }
+}
+
+
+/**
+ * Produit de convolution en virgule fixe : pixels sur 8 bits, noyau
+ * quantifié sur 16 bits, accumulation exacte sur 32 bits - écrase l'image
+ * originale
+ *
+ * L'image avec marges reste en plans d'octets, élargis à 16 bits dans les
+ * registres seulement ; chaque instruction pmaddwd fait deux produits par
+ * pixel, soit deux coefficients voisins d'une ligne du noyau. Les
+ * accumulateurs d'un bloc de pixels restent dans les registres pour tout le
+ * noyau. Le résultat est arrondi au plus proche, et identique d'une
+ * plateforme et d'un jeu d'instructions à l'autre.
+ */
+static void prod_conv_entier(LePNG & rgba, const Noyau & filtre)
+{
+    const int SEGMENT = 1024;
+
+    const int largeur = rgba.largeur();
+    const int hauteur = rgba.hauteur();
+    const int taille_filtre = filtre.largeur();
+    const int marge = (int)taille_filtre / 2;  // Type int (signé) nécessaire
+
+    const NoyauEntier quant(filtre);
+    JeuInstructions jeu = detecter_jeu_instructions();
+    const SegmentEntier segment = choisir_segment_entier(jeu);
+
+    // Paires de coefficients, retournés, des lignes non nulles du noyau :
+    // Sortie[i, j] = Sum(Im[i + ii, j + jj] * Filtre[marge - ii, marge - jj])
+    const int nb_paires = (taille_filtre + 1) / 2;
+    std::vector<int> decalages_lignes;
+    std::vector<int32_t> paires;
+    for (int ii = -marge; ii <= marge; ++ii) {
+        std::vector<uint32_t> ligne(nb_paires, 0);
+        bool nulle = true;
+
+        for (int t = 0; t < taille_filtre; ++t) {
+            const int16_t w = quant.valeurs[
+                (marge - ii) * taille_filtre + (taille_filtre - 1 - t)];
+            ligne[t / 2] |= (uint32_t)(uint16_t)w << (16 * (t & 1));
+            nulle = nulle && (w == 0);
+        }
+
+        if (!nulle) {
+            decalages_lignes.push_back(ii);
+            paires.insert(paires.end(), ligne.begin(), ligne.end());
+        }
+    }
+    const int nb_lignes = decalages_lignes.size();
+
+    const Image<png_byte> im8(rgba, marge);
+
+    std::cout << "Filtrage en virgule fixe (2^-" << quant.decalage << ", "
+        << NOMS_JEUX[jeu] << ") en cours ..." << std::endl;
+    std::cout << "  Écart maximal dû à la quantification : "
+        << quant.ecart_max << std::endl;
+
+#pragma omp parallel
+    {
+        std::vector<const png_byte *> lignes(nb_lignes);
+        std::vector<png_byte> canaux(3 * SEGMENT);
+
+#pragma omp for
+        for (int i = 0; i < hauteur; ++i) {
+            for (int j0 = 0; j0 < largeur; j0 += SEGMENT) {
+                const int n = std::min(SEGMENT, largeur - j0);
+
+                for (int c = 0; c < 3; ++c) {
+                    for (int l = 0; l < nb_lignes; ++l)
+                        lignes[l] = im8.ligne(c, i + decalages_lignes[l])
+                            + j0 - marge;
+
+                    segment(&canaux[c * SEGMENT], lignes.data(),
+                            paires.data(), nb_lignes, taille_filtre, n,
+                            quant.decalage, quant.arrondi);
+                }
+
+                // Placer le résultat dans l'image originale
+                entrelacer_rgb(&rgba[i * largeur + j0], &canaux[0],
+                               &canaux[SEGMENT], &canaux[2 * SEGMENT], n);
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,354 @@
+#ifndef MOTEURFLUX_HPP
+#define MOTEURFLUX_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FluxPNG.hpp"
+#include "Image.hpp"
+#include "MoteurOctets.hpp"
+#include "Noyau.hpp"
+
+
+/**
+ * Tampon circulaire de lignes avec marges de gauche et de droite, en plans
+ * d'octets : la ligne r (de -marge à hauteur + marge - 1) est dans
+ * l'emplacement (r + marge) % capacite ; le canal alpha suit
+ */
+class TamponLignes
+{
+public:
+    TamponLignes(int largeur, int hauteur, int marge, int capacite):
+        im(largeur, capacite, marge), h(hauteur), cap(capacite), lue(largeur) {}
+
+    inline png_byte * ligne(int c, int r) {
+        return im.ligne(c, (r + im.marge()) % cap);
+    }
+    inline const png_byte * ligne(int c, int r) const {
+        return im.ligne(c, (r + im.marge()) % cap);
+    }
+
+    inline int capacite() const { return cap; }
+    size_t octets() const {
+        return 4 * (size_t)im.stride() * (cap + 2 * im.marge());
+    }
+
+    /**
+     * Charger la ligne r, dans l'ordre à partir de -marge : les lignes de
+     * l'image sont lues du décodeur, celles des marges du haut et du bas
+     * sont en miroir (-1 -> 0 et hauteur -> hauteur - 1), comme celles de
+     * ImageMarges, à partir des lignes encore dans le tampon
+     */
+    void charger(int r, LecteurPNG & lecteur) {
+        const int largeur = im.largeur();
+        const int marge = im.marge();
+
+        if (r >= 0 && r < h) {
+            lecteur.lire_ligne(&lue[0]);
+            for (int c = 0; c < 4; ++c) {
+                png_byte * x = ligne(c, r);
+                for (int j = 0; j < largeur; ++j)
+                    x[j] = (&lue[j].r)[c];
+                for (int j = 0; j < marge; ++j) {
+                    x[-1 - j] = x[j];
+                    x[largeur + j] = x[largeur - 1 - j];
+                }
+            }
+
+            // Les marges du haut sont les copies des premières lignes
+            if (r < marge) {
+                for (int c = 0; c < 4; ++c)
+                    std::copy(ligne(c, r) - marge, ligne(c, r) + largeur + marge,
+                              ligne(c, -1 - r) - marge);
+            }
+        }
+        else if (r >= h) {
+            for (int c = 0; c < 4; ++c)
+                std::copy(ligne(c, 2 * h - 1 - r) - marge,
+                          ligne(c, 2 * h - 1 - r) + largeur + marge,
+                          ligne(c, r) - marge);
+        }
+        // r < 0 : copiée avec la ligne -1 - r
+    }
+
+private:
+    Image<png_byte, 4> im;
+    int h;
+    int cap;
+    std::vector<png_rgba> lue;
+};
+
+
+/**
+ * Lignes de sortie i0 .. i0 + n - 1, calculées en parallèle (parcours de
+ * prod_conv_octets()) à partir des lignes chargées dans le tampon
+ */
+static void filtrer_bande(const TamponLignes & tampon,
+                          const std::vector<float> & poids, int taille_filtre,
+                          AxpyOctets axpy, int largeur, int i0, int n,
+                          png_rgba * sortie)
+{
+    const int marge = taille_filtre / 2;
+
+#pragma omp parallel
+    {
+        std::vector<float> acc(largeur);
+
+#pragma omp for schedule(dynamic)
+        for (int b = 0; b < n; ++b) {
+            const int i = i0 + b;
+            png_rgba * ligne = &sortie[b * largeur];
+
+            for (int c = 0; c < 3; ++c) {
+                std::fill(acc.begin(), acc.end(), 0.f);
+
+                for (int ii = -marge; ii <= marge; ++ii) {
+                    const png_byte * x = tampon.ligne(c, i + ii);
+
+                    for (int jj = -marge; jj <= marge; ++jj) {
+                        const float w = poids[
+                            (marge - ii) * taille_filtre + (marge - jj)];
+                        if (w != 0.f)
+                            axpy(&acc[0], x + jj, w, largeur);
+                    }
+                }
+
+                for (int j = 0; j < largeur; ++j)
+                    (&ligne[j].r)[c] = saturer(acc[j]);
+            }
+
+            const png_byte * alpha = tampon.ligne(3, i);
+            for (int j = 0; j < largeur; ++j)
+                ligne[j].a = alpha[j];
+        }
+    }
+}
+
+
+/**
+ * Produit de convolution en flux, d'un fichier PNG à un autre : l'image
+ * n'est jamais entièrement en mémoire
+ *
+ * Les lignes sont lues du décodeur au besoin dans un tampon circulaire de
+ * K + BANDE - 1 lignes ; chaque bande de BANDE lignes de sortie est calculée
+ * en parallèle puis transmise directement à l'encodeur. La mémoire est ainsi
+ * proportionnelle à K x largeur plutôt qu'à hauteur x largeur.
+ */
+static void prod_conv_flux(const std::string & nom_entree,
+                           const std::string & nom_sortie,
+                           const Noyau & filtre)
+{
+    const int BANDE = 32;
+
+    LecteurPNG lecteur;
+    lecteur.ouvrir(nom_entree);
+
+    const int largeur = lecteur.largeur();
+    const int hauteur = lecteur.hauteur();
+    const int taille_filtre = filtre.largeur();
+    const int marge = (int)taille_filtre / 2;  // Type int (signé) nécessaire
+
+    if (marge > hauteur || marge > largeur)
+        throw nom_entree + " - image plus petite que la marge du noyau.";
+
+    EcrivainPNG ecrivain;
+    ecrivain.ouvrir(nom_sortie, largeur, hauteur);
+
+    const JeuInstructions jeu = detecter_jeu_instructions();
+    const AxpyOctets axpy = choisir_axpy_octets(jeu);
+
+    TamponLignes tampon(largeur, hauteur, marge, taille_filtre + BANDE - 1);
+
+    std::cout << "Filtrage en flux (" << NOMS_JEUX[jeu] << ", tampon de "
+        << tampon.capacite() << " lignes, " << tampon.octets()
+        << " octets) en cours ..." << std::endl;
+
+    std::vector<png_rgba> sortie(BANDE * largeur);
+    std::vector<float> poids(filtre.begin(), filtre.end());
+    int prochaine = -marge;  // Prochaine ligne avec marges à charger
+
+    for (int i0 = 0; i0 < hauteur; i0 += BANDE) {
+        const int n = std::min(BANDE, hauteur - i0);
+
+        // Charger les lignes i0 - marge .. i0 + n - 1 + marge
+        for (; prochaine <= i0 + n - 1 + marge; ++prochaine)
+            tampon.charger(prochaine, lecteur);
+
+        filtrer_bande(tampon, poids, taille_filtre, axpy, largeur, i0, n,
+                      &sortie[0]);
+
+        for (int b = 0; b < n; ++b)
+            ecrivain.ecrire_ligne(&sortie[b * largeur]);
+    }
+
+    ecrivain.fermer();
+}
+
+
+/**
+ * Produit de convolution en flux à trois étages concurrents : décodage,
+ * filtrage et encodage se chevauchent au lieu de se suivre
+ *
+ * Un fil d'exécution décode les lignes dans le tampon circulaire, agrandi
+ * de deux bandes pour pouvoir prendre de l'avance ; une ligne n'y est
+ * écrasée qu'une fois calculées toutes les lignes de sortie qui la lisent.
+ * Le fil principal et son équipe OpenMP filtrent chaque bande dès que ses
+ * lignes sont chargées, dans l'un de SORTIES tampons de bande, qu'un autre
+ * fil transmet à l'encodeur dans l'ordre. Les étages ne se chevauchent
+ * que s'il reste des coeurs libres pour le décodeur et l'encodeur ; la
+ * durée de travail de chaque étage est affichée, à comparer à la durée
+ * totale pour mesurer ce chevauchement.
+ */
+static void prod_conv_flux_concurrent(const std::string & nom_entree,
+                                      const std::string & nom_sortie,
+                                      const Noyau & filtre)
+{
+    const int BANDE = 32;
+    const int SORTIES = 3;
+
+    LecteurPNG lecteur;
+    lecteur.ouvrir(nom_entree);
+
+    const int largeur = lecteur.largeur();
+    const int hauteur = lecteur.hauteur();
+    const int taille_filtre = filtre.largeur();
+    const int marge = (int)taille_filtre / 2;  // Type int (signé) nécessaire
+    const int nb_bandes = (hauteur + BANDE - 1) / BANDE;
+
+    if (marge > hauteur || marge > largeur)
+        throw nom_entree + " - image plus petite que la marge du noyau.";
+
+    EcrivainPNG ecrivain;
+    ecrivain.ouvrir(nom_sortie, largeur, hauteur);
+
+    const JeuInstructions jeu = detecter_jeu_instructions();
+    const AxpyOctets axpy = choisir_axpy_octets(jeu);
+
+    TamponLignes tampon(largeur, hauteur, marge,
+                        taille_filtre + 3 * BANDE - 1);
+
+    std::cout << "Filtrage en flux concurrent (" << NOMS_JEUX[jeu]
+        << ", tampon de " << tampon.capacite() << " lignes, "
+        << tampon.octets() << " octets) en cours ..." << std::endl;
+
+    std::vector<png_rgba> sortie(SORTIES * BANDE * largeur);
+    std::vector<float> poids(filtre.begin(), filtre.end());
+
+    // État partagé entre les étages, protégé par verrou
+    std::mutex verrou;
+    std::condition_variable signal;
+    int chargees = -marge;   // Lignes -marge .. chargees - 1 dans le tampon
+    int calculees = 0;       // Lignes de sortie 0 .. calculees - 1 calculées
+    int encodees = 0;        // Bandes 0 .. encodees - 1 transmises
+    std::string erreur;      // Message du premier étage en échec
+
+    // Durées de travail de chaque étage, attentes exclues
+    typedef std::chrono::steady_clock Horloge;
+    std::chrono::duration<double> duree_decodage(0.), duree_filtrage(0.),
+        duree_encodage(0.);
+
+    std::thread decodeur([&] {
+        try {
+            for (int r = -marge; r < hauteur + marge; ++r) {
+                // La ligne r écrase la ligne r - capacite, lue par les
+                // lignes de sortie jusqu'à r - capacite + marge
+                {
+                    std::unique_lock<std::mutex> l(verrou);
+                    signal.wait(l, [&] { return !erreur.empty() ||
+                        r - tampon.capacite() + marge < calculees; });
+                    if (!erreur.empty())
+                        return;
+                }
+
+                const Horloge::time_point t0 = Horloge::now();
+                tampon.charger(r, lecteur);
+                duree_decodage += Horloge::now() - t0;
+
+                std::lock_guard<std::mutex> l(verrou);
+                chargees = r + 1;
+                signal.notify_all();
+            }
+        }
+        catch (const std::string & message) {
+            std::lock_guard<std::mutex> l(verrou);
+            erreur = message;
+            signal.notify_all();
+        }
+    });
+
+    std::thread encodeur([&] {
+        try {
+            for (int b = 0; b < nb_bandes; ++b) {
+                {
+                    std::unique_lock<std::mutex> l(verrou);
+                    signal.wait(l, [&] { return !erreur.empty() ||
+                        calculees >= std::min(hauteur, (b + 1) * BANDE); });
+                    if (!erreur.empty())
+                        return;
+                }
+
+                const Horloge::time_point t0 = Horloge::now();
+                const int n = std::min(BANDE, hauteur - b * BANDE);
+                const png_rgba * bande =
+                    &sortie[(b % SORTIES) * BANDE * largeur];
+                for (int k = 0; k < n; ++k)
+                    ecrivain.ecrire_ligne(&bande[k * largeur]);
+                duree_encodage += Horloge::now() - t0;
+
+                std::lock_guard<std::mutex> l(verrou);
+                encodees = b + 1;
+                signal.notify_all();
+            }
+        }
+        catch (const std::string & message) {
+            std::lock_guard<std::mutex> l(verrou);
+            erreur = message;
+            signal.notify_all();
+        }
+    });
+
+    for (int b = 0; b < nb_bandes; ++b) {
+        const int i0 = b * BANDE;
+        const int n = std::min(BANDE, hauteur - i0);
+
+        // Lignes i0 - marge .. i0 + n - 1 + marge chargées, et tampon de
+        // bande libéré par l'encodeur
+        {
+            std::unique_lock<std::mutex> l(verrou);
+            signal.wait(l, [&] { return !erreur.empty() ||
+                (chargees > i0 + n - 1 + marge && encodees > b - SORTIES); });
+            if (!erreur.empty())
+                break;
+        }
+
+        const Horloge::time_point t0 = Horloge::now();
+        filtrer_bande(tampon, poids, taille_filtre, axpy, largeur, i0, n,
+                      &sortie[(b % SORTIES) * BANDE * largeur]);
+        duree_filtrage += Horloge::now() - t0;
+
+        std::lock_guard<std::mutex> l(verrou);
+        calculees = i0 + n;
+        signal.notify_all();
+    }
+
+    decodeur.join();
+    encodeur.join();
+
+    if (!erreur.empty())
+        throw erreur;
+
+    const Horloge::time_point t0 = Horloge::now();
+    ecrivain.fermer();
+    duree_encodage += Horloge::now() - t0;
+
+    std::cout << "Étages : décodage " << duree_decodage.count()
+        << " s, filtrage " << duree_filtrage.count() << " s, encodage "
+        << duree_encodage.count() << " s" << std::endl;
+}
+
+#endif
@@ -0,0 +1,237 @@
+#ifndef MOTEURINCREMENTAL_HPP
+#define MOTEURINCREMENTAL_HPP
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "LePNG.hpp"
+#include "MoteurDirect.hpp"
+#include "Noyau.hpp"
+
+
+/**
+ * Région rectangulaire de l'image : lignes [i, i + hauteur), colonnes
+ * [j, j + largeur)
+ */
+struct Rectangle {
+    int i, j, hauteur, largeur;
+};
+
+
+/**
+ * Rectangles couvrant les pixels qui diffèrent entre deux images de mêmes
+ * dimensions, alpha compris, par blocs de bloc x bloc pixels ; les blocs
+ * modifiés consécutifs d'une même rangée sont regroupés
+ */
+static std::vector<Rectangle> detecter_changements(const LePNG & precedente,
+                                                   const LePNG & courante,
+                                                   int bloc = 16)
+{
+    if (precedente.largeur() != courante.largeur() ||
+        precedente.hauteur() != courante.hauteur())
+        throw std::string("les images successives n'ont pas les mêmes"
+            " dimensions.");
+
+    const int largeur = courante.largeur();
+    const int hauteur = courante.hauteur();
+    std::vector<Rectangle> changements;
+
+    for (int i0 = 0; i0 < hauteur; i0 += bloc) {
+        const int ni = std::min(bloc, hauteur - i0);
+        int debut = -1;  // Premier bloc modifié de la suite en cours
+
+        for (int j0 = 0; j0 < largeur; j0 += bloc) {
+            bool modifie = false;
+
+            for (int i = i0; i < i0 + ni && !modifie; ++i) {
+                for (int j = j0; j < std::min(j0 + bloc, largeur); ++j) {
+                    const png_rgba & a = precedente[i * largeur + j];
+                    const png_rgba & b = courante[i * largeur + j];
+                    if (a.r != b.r || a.g != b.g || a.b != b.b ||
+                        a.a != b.a) {
+                        modifie = true;
+                        break;
+                    }
+                }
+            }
+
+            if (modifie && debut < 0) {
+                debut = j0;
+            }
+            else if (!modifie && debut >= 0) {
+                Rectangle r = {i0, debut, ni, j0 - debut};
+                changements.push_back(r);
+                debut = -1;
+            }
+        }
+
+        if (debut >= 0) {
+            Rectangle r = {i0, debut, ni, largeur - debut};
+            changements.push_back(r);
+        }
+    }
+
+    return changements;
+}
+
+
+/**
+ * Union des rectangles dilatés de marge pixels, limités à l'image, en
+ * rectangles disjoints : intervalles de colonnes couverts ligne par ligne,
+ * les lignes consécutives aux mêmes intervalles formant un seul rectangle.
+ * Les voisins qui se chevauchent après dilatation ne sont ainsi recalculés
+ * qu'une fois.
+ */
+static std::vector<Rectangle> dilater_fusionner(
+    const std::vector<Rectangle> & changements, int marge, int largeur,
+    int hauteur)
+{
+    typedef std::pair<int, int> Intervalle;  // Colonnes [first, second)
+
+    std::vector<Rectangle> fusion;
+    std::vector<Intervalle> precedents;
+    std::vector<size_t> ouverts;  // Rectangles prolongés par la ligne
+
+    for (int i = 0; i <= hauteur; ++i) {
+        std::vector<Intervalle> intervalles;
+
+        for (size_t k = 0; i < hauteur && k < changements.size(); ++k) {
+            const Rectangle & r = changements[k];
+            if (i < r.i - marge || i >= r.i + r.hauteur + marge)
+                continue;
+            const int j_min = std::max(0, r.j - marge);
+            const int j_max = std::min(largeur, r.j + r.largeur + marge);
+            if (j_min < j_max)
+                intervalles.push_back(Intervalle(j_min, j_max));
+        }
+
+        std::sort(intervalles.begin(), intervalles.end());
+        std::vector<Intervalle> unis;
+        for (size_t k = 0; k < intervalles.size(); ++k) {
+            if (!unis.empty() && intervalles[k].first <= unis.back().second)
+                unis.back().second =
+                    std::max(unis.back().second, intervalles[k].second);
+            else
+                unis.push_back(intervalles[k]);
+        }
+
+        if (unis == precedents) {
+            for (size_t k = 0; k < ouverts.size(); ++k)
+                ++fusion[ouverts[k]].hauteur;
+            continue;
+        }
+
+        ouverts.clear();
+        for (size_t k = 0; k < unis.size(); ++k) {
+            Rectangle r = {i, unis[k].first, 1,
+                           unis[k].second - unis[k].first};
+            ouverts.push_back(fusion.size());
+            fusion.push_back(r);
+        }
+        precedents.swap(unis);
+    }
+
+    return fusion;
+}
+
+
+/**
+ * Mise à jour incrémentale d'un produit de convolution - sortie contient
+ * le résultat de l'image précédente et reçoit celui de l'image courante,
+ * qui n'en diffère que dans les rectangles changements
+ *
+ * Seules les sorties de l'union des rectangles dilatés de la marge du
+ * noyau sont recalculées, par la boucle de prod_conv_direct() sur des
+ * indices miroirs, et y reprennent l'alpha de l'image courante : le
+ * résultat est identique à celui d'un filtrage direct complet. Au-delà de
+ * FRACTION_MAX de l'image, un filtrage direct complet coûte moins que la
+ * boucle sur indices miroirs et le remplace.
+ */
+static void prod_conv_incremental(const LePNG & courante, LePNG & sortie,
+                                  const Noyau & filtre,
+                                  const std::vector<Rectangle> & changements)
+{
+    const int largeur = courante.largeur();
+    const int hauteur = courante.hauteur();
+    const int taille_filtre = filtre.largeur();
+    const int marge = (int)taille_filtre / 2;  // Type int (signé) nécessaire
+    const double FRACTION_MAX = 0.5;
+
+    const std::vector<Rectangle> regions =
+        dilater_fusionner(changements, marge, largeur, hauteur);
+
+    long pixels = 0;
+    for (size_t k = 0; k < regions.size(); ++k)
+        pixels += (long)regions[k].hauteur * regions[k].largeur;
+
+    if (pixels > FRACTION_MAX * largeur * hauteur) {
+        std::cout << "Filtrage incrémental : " << changements.size()
+            << " rectangles, " << pixels << " pixels à recalculer sur "
+            << (long)largeur * hauteur << ", filtrage complet" << std::endl;
+
+        sortie = courante;
+        prod_conv_direct(sortie, filtre);
+        return;
+    }
+
+    for (size_t k = 0; k < regions.size(); ++k) {
+        const int i_min = regions[k].i;
+        const int j_min = regions[k].j;
+        const int i_max = regions[k].i + regions[k].hauteur;
+        const int j_max = regions[k].j + regions[k].largeur;
+
+        // Colonnes miroirs lues par le rectangle, comme les marges de
+        // ImageMarges : -1 -> 0, largeur -> largeur - 1
+        std::vector<int> col(j_max - j_min + 2 * marge);
+        for (int y = 0; y < (int)col.size(); ++y) {
+            int j = j_min - marge + y;
+            if (j < 0)
+                j = -1 - j;
+            if (j >= largeur)
+                j = 2 * largeur - 1 - j;
+            col[y] = j;
+        }
+
+#pragma omp parallel for
+        for (int i = i_min; i < i_max; ++i) {
+            for (int j = j_min; j < j_max; ++j) {
+                double r = 0.;
+                double g = 0.;
+                double b = 0.;
+
+                for (int ii = -marge; ii <= marge; ++ii) {
+                    int ligne = i + ii;
+                    if (ligne < 0)
+                        ligne = -1 - ligne;
+                    if (ligne >= hauteur)
+                        ligne = 2 * hauteur - 1 - ligne;
+                    const png_rgba * im = &courante[ligne * largeur];
+                    const int * c = &col[j - j_min + marge];
+
+                    for (int jj = -marge; jj <= marge; ++jj) {
+                        const png_rgba & p = im[c[jj]];
+                        const Noyau::size_type index_filt =
+                            (marge - ii) * taille_filtre + (marge - jj);
+
+                        r += (double)p.r * filtre[index_filt];
+                        g += (double)p.g * filtre[index_filt];
+                        b += (double)p.b * filtre[index_filt];
+                    }
+                }
+
+                sortie[i * largeur + j].r = saturer(r);
+                sortie[i * largeur + j].g = saturer(g);
+                sortie[i * largeur + j].b = saturer(b);
+                sortie[i * largeur + j].a = courante[i * largeur + j].a;
+            }
+        }
+    }
+
+    std::cout << "Filtrage incrémental : " << changements.size()
+        << " rectangles (" << regions.size() << " après fusion), " << pixels
+        << " pixels recalculés sur "
+        << (long)largeur * hauteur << std::endl;
+}
+
+#endif
@@ -0,0 +1,168 @@
+#ifndef MOTEUROCTETS_HPP
+#define MOTEUROCTETS_HPP
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "Image.hpp"
+#include "MoteurSIMD.hpp"
+#include "Noyau.hpp"
+
+
+/**
+ * Acc[0..n) += Im[0..n) * w, pixels sur 8 bits convertis en simple
+ * précision dans les registres, une version par jeu d'instructions
+ */
+typedef void (*AxpyOctets)(float * acc, const png_byte * im, float w, int n);
+
+static void axpy_octets_scalaire(float * acc, const png_byte * im, float w,
+                                 int n)
+{
+    for (int j = 0; j < n; ++j)
+        acc[j] += im[j] * w;
+}
+
+#ifdef MOTEURSIMD_X86
+__attribute__((target("sse4.2")))
+static void axpy_octets_sse42(float * acc, const png_byte * im, float w,
+                              int n)
+{
+    const __m128 vw = _mm_set1_ps(w);
+    int j = 0;
+
+    for (; j + 4 <= n; j += 4) {
+        int quatre;
+        memcpy(&quatre, im + j, sizeof quatre);
+        const __m128 x = _mm_cvtepi32_ps(
+            _mm_cvtepu8_epi32(_mm_cvtsi32_si128(quatre)));
+        _mm_storeu_ps(acc + j,
+            _mm_add_ps(_mm_loadu_ps(acc + j), _mm_mul_ps(x, vw)));
+    }
+    for (; j < n; ++j)
+        acc[j] += im[j] * w;
+}
+
+__attribute__((target("avx2,fma")))
+static void axpy_octets_avx2(float * acc, const png_byte * im, float w,
+                             int n)
+{
+    const __m256 vw = _mm256_set1_ps(w);
+    int j = 0;
+
+    for (; j + 8 <= n; j += 8) {
+        const __m256 x = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(
+            _mm_loadl_epi64((const __m128i *)(im + j))));
+        _mm256_storeu_ps(acc + j,
+            _mm256_fmadd_ps(x, vw, _mm256_loadu_ps(acc + j)));
+    }
+    for (; j < n; ++j)
+        acc[j] += im[j] * w;
+}
+
+__attribute__((target("avx512f")))
+static void axpy_octets_avx512(float * acc, const png_byte * im, float w,
+                               int n)
+{
+    const __m512 vw = _mm512_set1_ps(w);
+    int j = 0;
+
+    for (; j + 16 <= n; j += 16) {
+        // Formes masquées : les autres laissent un avertissement de GCC
+        // sur une valeur non initialisée
+        const __m512 x = _mm512_maskz_cvtepi32_ps(0xFFFF,
+            _mm512_maskz_cvtepu8_epi32(0xFFFF,
+                _mm_loadu_si128((const __m128i *)(im + j))));
+        _mm512_storeu_ps(acc + j,
+            _mm512_fmadd_ps(x, vw, _mm512_loadu_ps(acc + j)));
+    }
+    for (; j < n; ++j)
+        acc[j] += im[j] * w;
+}
+#endif
+
+
+static AxpyOctets choisir_axpy_octets(JeuInstructions jeu)
+{
+    switch (jeu) {
+#ifdef MOTEURSIMD_X86
+        case AVX512: return axpy_octets_avx512;
+        case AVX2: return axpy_octets_avx2;
+        case SSE42: return axpy_octets_sse42;
+#endif
+        default: return axpy_octets_scalaire;
+    }
+}
+
+
+/**
+ * Produit de convolution à mémoire réduite : l'image avec marges est
+ * conservée en plans d'octets et chaque pixel n'est converti en simple
+ * précision que dans les registres - écrase l'image originale
+ *
+ * La copie de travail occupe 3 octets par pixel, au lieu des 4 de l'image
+ * avec marges et des 24 des plans double ; seuls les accumulateurs d'un
+ * segment de ligne, en cache L1, sont en virgule flottante. Le parcours
+ * est celui de prod_conv_simd().
+ */
+static void prod_conv_octets(LePNG & rgba, const Noyau & filtre)
+{
+    const int SEGMENT = 2048;
+
+    const int largeur = rgba.largeur();
+    const int hauteur = rgba.hauteur();
+    const int taille_filtre = filtre.largeur();
+    const int marge = (int)taille_filtre / 2;  // Type int (signé) nécessaire
+
+    const JeuInstructions jeu = detecter_jeu_instructions();
+    const AxpyOctets axpy = choisir_axpy_octets(jeu);
+
+    const Image<png_byte> im8(rgba, marge);
+
+    std::cout << "Filtrage sur plans d'octets (" << NOMS_JEUX[jeu]
+        << ", " << 3 * (size_t)im8.stride() * (hauteur + 2 * marge)
+        << " octets) en cours ..." << std::endl;
+
+    std::vector<float> poids(filtre.begin(), filtre.end());
+
+#pragma omp parallel
+    {
+        Image<float> acc(SEGMENT, 1);
+        float * acc_r = acc.ligne(0, 0);
+        float * acc_g = acc.ligne(1, 0);
+        float * acc_b = acc.ligne(2, 0);
+
+#pragma omp for
+        for (int i = 0; i < hauteur; ++i) {
+            for (int j0 = 0; j0 < largeur; j0 += SEGMENT) {
+                const int n = std::min(SEGMENT, largeur - j0);
+
+                std::fill(acc_r, acc_r + n, 0.f);
+                std::fill(acc_g, acc_g + n, 0.f);
+                std::fill(acc_b, acc_b + n, 0.f);
+
+                for (int ii = -marge; ii <= marge; ++ii) {
+                    for (int jj = -marge; jj <= marge; ++jj) {
+                        const float w = poids[
+                            (marge - ii) * taille_filtre + (marge - jj)];
+                        if (w == 0.f)
+                            continue;
+
+                        axpy(acc_r, im8.ligne(0, i + ii) + j0 + jj, w, n);
+                        axpy(acc_g, im8.ligne(1, i + ii) + j0 + jj, w, n);
+                        axpy(acc_b, im8.ligne(2, i + ii) + j0 + jj, w, n);
+                    }
+                }
+
+                // Placer le résultat dans l'image originale
+                for (int j = 0; j < n; ++j) {
+                    rgba[i * largeur + j0 + j].r = saturer(acc_r[j]);
+                    rgba[i * largeur + j0 + j].g = saturer(acc_g[j]);
+                    rgba[i * largeur + j0 + j].b = saturer(acc_b[j]);
+                }
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,200 @@
+#ifndef MOTEURPIPELINE_HPP
+#define MOTEURPIPELINE_HPP
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "LePNG.hpp"
+#include "Noyau.hpp"
+
+
+/**
+ * Composition analytique d'une chaîne de noyaux : appliquer etapes[0],
+ * puis etapes[1], ... sans saturation intermédiaire équivaut à appliquer
+ * le noyau composé, produit de convolution complet des noyaux, de taille
+ * Somme(K) - (nombre d'étapes - 1).
+ *
+ * Seules les marges diffèrent : le miroir n'est appliqué qu'une fois, à
+ * l'image originale, plutôt qu'au résultat de chaque étape.
+ */
+static Noyau composer(const std::vector<Noyau> & etapes,
+                      double tolerance = 1e-4, double seuil = 0.)
+{
+    std::vector<double> compose(etapes[0].begin(), etapes[0].end());
+    int taille = etapes[0].largeur();
+
+    for (size_t s = 1; s < etapes.size(); ++s) {
+        const int kb = etapes[s].largeur();
+        const int kc = taille + kb - 1;
+        std::vector<double> produit(kc * kc, 0.);
+
+        // Produit[p, q] = Sum_a,b(Compose[a, b] * Etape[p - a, q - b])
+        for (int a = 0; a < taille; ++a) {
+            for (int b = 0; b < taille; ++b) {
+                const double w = compose[a * taille + b];
+                if (w == 0.)
+                    continue;
+
+                for (int u = 0; u < kb; ++u) {
+                    for (int v = 0; v < kb; ++v)
+                        produit[(a + u) * kc + (b + v)] +=
+                            w * etapes[s][u * kb + v];
+                }
+            }
+        }
+
+        compose.swap(produit);
+        taille = kc;
+    }
+
+    Noyau resultat;
+    resultat.definir(taille, compose, tolerance, seuil);
+    return resultat;
+}
+
+
+/**
+ * Indice miroir, tel que les marges de ImageMarges : -1 -> 0, n -> n-1
+ */
+static inline int miroir(int x, int n)
+{
+    if (x < 0)
+        x = -1 - x;
+    if (x >= n)
+        x = 2 * n - 1 - x;
+    return std::min(std::max(x, 0), n - 1);
+}
+
+
+/**
+ * Chaîne de noyaux fusionnée par tuiles : chaque étape reçoit le résultat
+ * miroité de la précédente, comme une suite d'exécutions séparées, mais
+ * les résultats intermédiaires restent en cache, en simple précision,
+ * sans passer par l'image ni par un fichier PNG.
+ *
+ * Pour chaque tuile de sortie, l'étape s calcule la tuile élargie de la
+ * somme des marges des étapes suivantes ; les positions hors de l'image y
+ * reçoivent la valeur de leur position miroir. Par défaut, la chaîne
+ * reste linéaire, sans saturation intermédiaire (voir aussi composer()) ;
+ * si saturer_etapes est vrai, chaque résultat intermédiaire est saturé et
+ * tronqué comme l'octet d'une image, ce qui reproduit les exécutions
+ * séparées.
+ */
+static void prod_conv_pipeline(LePNG & rgba, const std::vector<Noyau> & etapes,
+                               bool saturer_etapes = false)
+{
+    const int largeur = rgba.largeur();
+    const int hauteur = rgba.hauteur();
+    const int nb_etapes = etapes.size();
+
+    // Demi-largeur de la région produite par chaque étape ; l'entrée de la
+    // première étape est élargie de toutes les marges
+    std::vector<int> region(nb_etapes + 1, 0);
+    for (int s = nb_etapes - 1; s >= 0; --s)
+        region[s] = region[s + 1] + (int)etapes[s].largeur() / 2;
+    const int marge = region[0];
+
+    // Tuiles assez grandes pour amortir le recalcul des marges
+    const int TUILE = std::max(64, (2 * marge + 15) & ~15);
+
+    std::cout << "Filtrage par " << nb_etapes << " étapes fusionnées"
+        << " (marge totale " << marge << ", tuiles " << TUILE << " x "
+        << TUILE << ") en cours ..." << std::endl;
+
+    const LePNG original(rgba);
+    const int tuiles_i = (hauteur + TUILE - 1) / TUILE;
+    const int tuiles_j = (largeur + TUILE - 1) / TUILE;
+    const int taille_max = (TUILE + 2 * marge) * (TUILE + 2 * marge);
+
+#pragma omp parallel
+    {
+        std::vector<float> entree(taille_max), sortie(taille_max);
+        std::vector<int> lig(TUILE + 2 * marge), col(TUILE + 2 * marge);
+
+#pragma omp for collapse(2) schedule(dynamic)
+        for (int ti = 0; ti < tuiles_i; ++ti) {
+            for (int tj = 0; tj < tuiles_j; ++tj) {
+                const int i0 = ti * TUILE;
+                const int j0 = tj * TUILE;
+                const int ni = std::min(TUILE, hauteur - i0);
+                const int nj = std::min(TUILE, largeur - j0);
+
+                for (int c = 0; c < 3; ++c) {
+                    // Entrée[x, y] = Im[miroir(i0 - marge + x),
+                    //                   miroir(j0 - marge + y)]
+                    int stride_e = nj + 2 * marge;
+                    for (int x = 0; x < ni + 2 * marge; ++x) {
+                        const png_rgba * ligne = &original[
+                            miroir(i0 - marge + x, hauteur) * largeur];
+                        for (int y = 0; y < nj + 2 * marge; ++y)
+                            entree[x * stride_e + y] =
+                                (&ligne[miroir(j0 - marge + y, largeur)].r)[c];
+                    }
+
+                    for (int s = 0; s < nb_etapes; ++s) {
+                        const std::vector<Coefficient> & coef =
+                            etapes[s].coefficients();
+                        const int r_e = region[s];
+                        const int r_s = region[s + 1];
+                        const int hi = ni + 2 * r_s;
+                        const int lj = nj + 2 * r_s;
+
+                        // Position miroir de chaque ligne et colonne
+                        // produite, relative à l'origine de l'entrée
+                        for (int x = 0; x < hi; ++x)
+                            lig[x] = miroir(i0 - r_s + x, hauteur)
+                                - (i0 - r_e);
+                        for (int y = 0; y < lj; ++y)
+                            col[y] = miroir(j0 - r_s + y, largeur)
+                                - (j0 - r_e);
+                        const bool contigu = (j0 - r_s >= 0) &&
+                            (j0 + nj + r_s <= largeur);
+
+                        std::fill(&sortie[0], &sortie[0] + hi * lj, 0.f);
+
+                        for (int x = 0; x < hi; ++x) {
+                            float * a = &sortie[x * lj];
+
+                            for (size_t t = 0; t < coef.size(); ++t) {
+                                const float w = coef[t].poids;
+                                const float * f = &entree[
+                                    (lig[x] + coef[t].di) * stride_e
+                                    + coef[t].dj];
+
+                                if (contigu) {
+                                    f += col[0];
+#pragma omp simd
+                                    for (int y = 0; y < lj; ++y)
+                                        a[y] += f[y] * w;
+                                }
+                                else {
+                                    for (int y = 0; y < lj; ++y)
+                                        a[y] += f[col[y]] * w;
+                                }
+                            }
+
+                            if (saturer_etapes && s < nb_etapes - 1) {
+                                for (int y = 0; y < lj; ++y)
+                                    a[y] = saturer(a[y]);
+                            }
+                        }
+
+                        entree.swap(sortie);
+                        stride_e = lj;
+                    }
+
+                    // Placer le résultat de la dernière étape dans l'image
+                    for (int x = 0; x < ni; ++x) {
+                        for (int y = 0; y < nj; ++y) {
+                            png_byte * p = &rgba[(i0 + x) * largeur + j0 + y].r;
+                            p[c] = saturer(entree[x * nj + y]);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,247 @@
+#ifndef MOTEURRECURSIF_HPP
+#define MOTEURRECURSIF_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "Image.hpp"
+#include "Noyau.hpp"
+
+
+/**
+ * Filtre récursif gaussien d'ordre 3 de Young et van Vliet (1995) :
+ * w[n] = B x[n] + (b1 w[n-1] + b2 w[n-2] + b3 w[n-3]) / b0 en avant,
+ * puis la même récurrence en arrière. Coût constant par pixel, quel que
+ * soit l'écart-type.
+ */
+struct FiltreRecursif
+{
+    /**
+     * Ajustement au noyau : gain égal à la somme de ses coefficients, et
+     * écart-type de la gaussienne échantillonnée (normalisée sur K points)
+     * la plus proche du noyau. L'ajustement se fait quel que soit le noyau ;
+     * le résidu, somme des écarts absolus entre le noyau et cette
+     * gaussienne, est conservé pour être rapporté avec la borne de l'écart.
+     */
+    explicit FiltreRecursif(const Noyau & filtre) {
+        const int k = filtre.largeur();
+
+        gain = 0.;
+        for (int i = 0; i < k * k; ++i)
+            gain += filtre[i];
+
+        // Balayage logarithmique de 0,3 à K / 2, puis section dorée autour
+        // du meilleur écart-type ; au-delà, la gaussienne tronquée n'est
+        // plus qu'une boîte aux bords adoucis
+        const int ESSAIS = 64;
+        const double sigma_max = std::max(0.5, 0.5 * k);
+        double meilleur = 0.3;
+        double ecart_min = -1.;
+        for (int essai = 0; essai <= ESSAIS; ++essai) {
+            const double s = 0.3 * std::pow(sigma_max / 0.3, (double)essai / ESSAIS);
+            const double e = ecart_gaussienne(filtre, s);
+            if (ecart_min < 0. || e < ecart_min) {
+                ecart_min = e;
+                meilleur = s;
+            }
+        }
+
+        const double pas = std::pow(sigma_max / 0.3, 1. / ESSAIS);
+        double a = meilleur / pas, b = std::min(meilleur * pas, sigma_max);
+        const double or_ = 0.5 * (std::sqrt(5.) - 1.);
+        for (int iter = 0; iter < 60; ++iter) {
+            const double c = b - or_ * (b - a), d = a + or_ * (b - a);
+            if (ecart_gaussienne(filtre, c) < ecart_gaussienne(filtre, d))
+                b = d;
+            else
+                a = c;
+        }
+        if (ecart_gaussienne(filtre, 0.5 * (a + b)) < ecart_min) {
+            meilleur = 0.5 * (a + b);
+            ecart_min = ecart_gaussienne(filtre, meilleur);
+        }
+
+        residu = ecart_min;
+        ecart_max = ajuster(filtre, meilleur);
+    }
+
+    /**
+     * Somme des écarts absolus entre le noyau et gain * g x g, g étant la
+     * gaussienne d'écart-type s échantillonnée sur K points et normalisée
+     */
+    double ecart_gaussienne(const Noyau & filtre, double s) const {
+        const int k = filtre.largeur();
+        const int marge = k / 2;
+        std::vector<double> g(k);
+        double somme = 0.;
+
+        for (int i = 0; i < k; ++i) {
+            g[i] = std::exp(-0.5 * (i - marge) * (i - marge) / (s * s));
+            somme += g[i];
+        }
+        for (int i = 0; i < k; ++i)
+            g[i] /= somme;
+
+        double ecart = 0.;
+        for (int i = 0; i < k; ++i)
+            for (int j = 0; j < k; ++j)
+                ecart += std::fabs(filtre[i * k + j] - gain * g[i] * g[j]);
+
+        return ecart;
+    }
+
+    /**
+     * Coefficients pour l'écart-type s ; retourne la borne de l'écart, en
+     * niveaux de gris, avec le moteur direct : écart entre la réponse
+     * impulsionnelle 2D et le noyau, plus la partie de la réponse hors du
+     * noyau (lue par les passes mais pas par le produit direct), plus 1
+     * pour la troncature finale
+     */
+    double ajuster(const Noyau & filtre, double s) {
+        const int k = filtre.largeur();
+        const int marge = k / 2;
+
+        sigma = s;
+        const double q = (sigma >= 2.5) ?
+            0.98711 * sigma - 0.96330 :
+            3.97156 - 4.14554 * std::sqrt(1. - 0.26891 * std::max(sigma, 0.5));
+        const double q2 = q * q, q3 = q2 * q;
+        const double b0 = 1.57825 + 2.44413 * q + 1.4281 * q2 + 0.422205 * q3;
+
+        b1 = (2.44413 * q + 2.85619 * q2 + 1.26661 * q3) / b0;
+        b2 = -(1.4281 * q2 + 1.26661 * q3) / b0;
+        b3 = 0.422205 * q3 / b0;
+        B = 1. - (b1 + b2 + b3);
+
+        const int n = 2 * (k + (int)(8. * sigma));
+        std::vector<double> impulsion(n, 0.);
+        impulsion[n / 2] = 1.;
+        filtrer(&impulsion[0], n, 1);
+
+        double ecart = 0.;
+        for (int i = 0; i < k; ++i)
+            for (int j = 0; j < k; ++j)
+                ecart += std::fabs(filtre[i * k + j] - gain
+                    * impulsion[n / 2 + i - marge] * impulsion[n / 2 + j - marge]);
+
+        // Partie de la réponse 2D hors du noyau :
+        // (Sum|h|)^2 - (Sum|h| dans le noyau)^2
+        double total = 0., dedans = 0.;
+        for (int i = 0; i < n; ++i) {
+            total += std::fabs(impulsion[i]);
+            if (std::abs(i - n / 2) <= marge)
+                dedans += std::fabs(impulsion[i]);
+        }
+
+        return 255. * (ecart + std::fabs(gain) * (total * total - dedans * dedans))
+            + 1.;
+    }
+
+    /**
+     * Passes avant et arrière, en place, sur x[0], x[pas], ... x[(n-1)*pas] ;
+     * les bords sont prolongés par leur valeur (régime permanent)
+     */
+    void filtrer(double * x, int n, int pas) const {
+        double w1 = x[0], w2 = x[0], w3 = x[0];
+        for (int i = 0; i < n; ++i) {
+            const double w = B * x[i * pas] + b1 * w1 + b2 * w2 + b3 * w3;
+            x[i * pas] = w;
+            w3 = w2; w2 = w1; w1 = w;
+        }
+
+        w1 = w2 = w3 = x[(n - 1) * pas];
+        for (int i = n - 1; i >= 0; --i) {
+            const double w = B * x[i * pas] + b1 * w1 + b2 * w2 + b3 * w3;
+            x[i * pas] = w;
+            w3 = w2; w2 = w1; w1 = w;
+        }
+    }
+
+    double sigma, gain;
+    double B, b1, b2, b3;
+    double residu;
+    double ecart_max;
+};
+
+
+/**
+ * Produit de convolution approché par filtre récursif gaussien (mode sur
+ * demande) - écrase l'image originale
+ *
+ * Les passes s'appliquent à l'image avec marges en miroir, comme pour les
+ * autres moteurs. La passe verticale avance ligne par ligne sur toute la
+ * largeur, ce qui se vectorise et reste favorable au cache.
+ */
+static void prod_conv_recursif(LePNG & rgba, const Noyau & filtre)
+{
+    const int largeur = rgba.largeur();
+    const int hauteur = rgba.hauteur();
+    const int taille_filtre = filtre.largeur();
+    const int marge = (int)taille_filtre / 2;  // Type int (signé) nécessaire
+
+    const FiltreRecursif iir(filtre);
+
+    Image<double> plans(rgba, marge);
+    const int largeur_temp = largeur + 2 * marge;
+    const int hauteur_temp = hauteur + 2 * marge;
+
+    std::cout << "Filtrage récursif gaussien en cours (sigma = " << iir.sigma
+        << ", résidu de l'ajustement " << iir.residu
+        << ", borne de l'écart avec le moteur direct " << iir.ecart_max
+        << ") ..." << std::endl;
+
+    for (int c = 0; c < 3; ++c) {
+        // Coin supérieur gauche du plan avec marges
+        double * plan = plans.ligne(c, -marge) - marge;
+        const int stride = plans.stride();
+
+        // Passe horizontale, ligne par ligne
+#pragma omp parallel for
+        for (int i = 0; i < hauteur_temp; ++i)
+            iir.filtrer(&plan[i * stride], largeur_temp, 1);
+
+        // Passe verticale, toutes les colonnes d'un bloc à la fois
+#pragma omp parallel for
+        for (int j0 = 0; j0 < largeur_temp; j0 += 256) {
+            const int n = std::min(256, largeur_temp - j0);
+            std::vector<double> w1(&plan[j0], &plan[j0] + n);
+            std::vector<double> w2(w1), w3(w1);
+
+            for (int sens = 0; sens < 2; ++sens) {
+                for (int t = 0; t < hauteur_temp; ++t) {
+                    const int i = (sens == 0) ? t : hauteur_temp - 1 - t;
+                    double * x = &plan[i * stride + j0];
+
+#pragma omp simd
+                    for (int j = 0; j < n; ++j) {
+                        const double w = iir.B * x[j] + iir.b1 * w1[j]
+                            + iir.b2 * w2[j] + iir.b3 * w3[j];
+                        x[j] = w;
+                        w3[j] = w2[j]; w2[j] = w1[j]; w1[j] = w;
+                    }
+                }
+
+                // Régime permanent au bas de l'image pour la passe arrière
+                const double * dernier = &plan[(hauteur_temp - 1) * stride + j0];
+                w1.assign(dernier, dernier + n);
+                w2 = w1;
+                w3 = w1;
+            }
+        }
+
+        // Gain de normalisation
+#pragma omp parallel for
+        for (int i = 0; i < hauteur; ++i) {
+            double * x = plans.ligne(c, i);
+            for (int j = 0; j < largeur; ++j)
+                x[j] *= iir.gain;
+        }
+    }
+
+    // Placer le résultat dans l'image originale
+    plans.copier_vers(rgba);
+}
+
+#endif
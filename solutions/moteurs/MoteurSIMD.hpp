@@ -0,0 +1,198 @@
+#ifndef MOTEURSIMD_HPP
+#define MOTEURSIMD_HPP
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MOTEURSIMD_X86
+#endif
+
+#include "Image.hpp"
+#include "Noyau.hpp"
+
+
+/**
+ * Jeux d'instructions vectorielles pris en charge, du moins au plus large
+ */
+enum JeuInstructions { SCALAIRE, SSE42, AVX2, AVX512 };
+
+static const char * const NOMS_JEUX[] = { "scalaire", "sse42", "avx2", "avx512" };
+
+
+/**
+ * Meilleur jeu d'instructions du processeur (CPUID), ou celui imposé par
+ * la variable d'environnement CONVOLUTION_ISA (scalaire, sse42, avx2,
+ * avx512) s'il est disponible
+ */
+static JeuInstructions detecter_jeu_instructions()
+{
+    JeuInstructions jeu = SCALAIRE;
+
+#ifdef MOTEURSIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2"))
+        jeu = SSE42;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        jeu = AVX2;
+    if (__builtin_cpu_supports("avx512f"))
+        jeu = AVX512;
+#endif
+
+    const char * impose = getenv("CONVOLUTION_ISA");
+    if (impose) {
+        for (int j = SCALAIRE; j <= jeu; ++j)
+            if (strcmp(impose, NOMS_JEUX[j]) == 0)
+                return (JeuInstructions)j;
+    }
+
+    return jeu;
+}
+
+
+/**
+ * Acc[0..n) += Im[0..n) * w, une version par jeu d'instructions
+ */
+typedef void (*AxpyFloat)(float * acc, const float * im, float w, int n);
+
+static void axpy_scalaire(float * acc, const float * im, float w, int n)
+{
+    for (int j = 0; j < n; ++j)
+        acc[j] += im[j] * w;
+}
+
+#ifdef MOTEURSIMD_X86
+__attribute__((target("sse4.2")))
+static void axpy_sse42(float * acc, const float * im, float w, int n)
+{
+    const __m128 vw = _mm_set1_ps(w);
+    int j = 0;
+
+    for (; j + 4 <= n; j += 4) {
+        const __m128 v = _mm_mul_ps(_mm_loadu_ps(im + j), vw);
+        _mm_storeu_ps(acc + j, _mm_add_ps(_mm_loadu_ps(acc + j), v));
+    }
+    for (; j < n; ++j)
+        acc[j] += im[j] * w;
+}
+
+__attribute__((target("avx2,fma")))
+static void axpy_avx2(float * acc, const float * im, float w, int n)
+{
+    const __m256 vw = _mm256_set1_ps(w);
+    int j = 0;
+
+    for (; j + 8 <= n; j += 8) {
+        const __m256 v = _mm256_fmadd_ps(
+            _mm256_loadu_ps(im + j), vw, _mm256_loadu_ps(acc + j));
+        _mm256_storeu_ps(acc + j, v);
+    }
+    for (; j < n; ++j)
+        acc[j] += im[j] * w;
+}
+
+__attribute__((target("avx512f")))
+static void axpy_avx512(float * acc, const float * im, float w, int n)
+{
+    const __m512 vw = _mm512_set1_ps(w);
+    int j = 0;
+
+    for (; j + 16 <= n; j += 16) {
+        const __m512 v = _mm512_fmadd_ps(
+            _mm512_loadu_ps(im + j), vw, _mm512_loadu_ps(acc + j));
+        _mm512_storeu_ps(acc + j, v);
+    }
+    if (j < n) {
+        // Reste masqué plutôt que scalaire
+        const __mmask16 masque = (__mmask16)((1u << (n - j)) - 1);
+        const __m512 v = _mm512_fmadd_ps(
+            _mm512_maskz_loadu_ps(masque, im + j), vw,
+            _mm512_maskz_loadu_ps(masque, acc + j));
+        _mm512_mask_storeu_ps(acc + j, masque, v);
+    }
+}
+#endif
+
+
+static AxpyFloat choisir_axpy(JeuInstructions jeu)
+{
+    switch (jeu) {
+#ifdef MOTEURSIMD_X86
+        case AVX512: return axpy_avx512;
+        case AVX2: return axpy_avx2;
+        case SSE42: return axpy_sse42;
+#endif
+        default: return axpy_scalaire;
+    }
+}
+
+
+/**
+ * Produit de convolution en simple précision, vectorisé à la main pour
+ * SSE4.2, AVX2+FMA et AVX-512, choisi à l'exécution - écrase l'image
+ * originale
+ *
+ * Un seul exécutable, compilé sans -march, exploite ainsi chaque
+ * génération de nœuds. Le parcours est celui de prod_conv_axpy().
+ */
+static void prod_conv_simd(LePNG & rgba, const Noyau & filtre)
+{
+    const int SEGMENT = 2048;
+
+    const int largeur = rgba.largeur();
+    const int hauteur = rgba.hauteur();
+    const int taille_filtre = filtre.largeur();
+    const int marge = (int)taille_filtre / 2;  // Type int (signé) nécessaire
+
+    const JeuInstructions jeu = detecter_jeu_instructions();
+    const AxpyFloat axpy = choisir_axpy(jeu);
+
+    const Image<float> im32(rgba, marge);
+
+    std::cout << "Filtrage en simple précision (" << NOMS_JEUX[jeu]
+        << ") en cours ..." << std::endl;
+
+    std::vector<float> poids(filtre.begin(), filtre.end());
+
+#pragma omp parallel
+    {
+        Image<float> acc(SEGMENT, 1);
+        float * acc_r = acc.ligne(0, 0);
+        float * acc_g = acc.ligne(1, 0);
+        float * acc_b = acc.ligne(2, 0);
+
+#pragma omp for
+        for (int i = 0; i < hauteur; ++i) {
+            for (int j0 = 0; j0 < largeur; j0 += SEGMENT) {
+                const int n = std::min(SEGMENT, largeur - j0);
+
+                std::fill(acc_r, acc_r + n, 0.f);
+                std::fill(acc_g, acc_g + n, 0.f);
+                std::fill(acc_b, acc_b + n, 0.f);
+
+                for (int ii = -marge; ii <= marge; ++ii) {
+                    for (int jj = -marge; jj <= marge; ++jj) {
+                        const float w = poids[
+                            (marge - ii) * taille_filtre + (marge - jj)];
+
+                        axpy(acc_r, im32.ligne(0, i + ii) + j0 + jj, w, n);
+                        axpy(acc_g, im32.ligne(1, i + ii) + j0 + jj, w, n);
+                        axpy(acc_b, im32.ligne(2, i + ii) + j0 + jj, w, n);
+                    }
+                }
+
+                // Placer le résultat dans l'image originale
+                for (int j = 0; j < n; ++j) {
+                    rgba[i * largeur + j0 + j].r = saturer(acc_r[j]);
+                    rgba[i * largeur + j0 + j].g = saturer(acc_g[j]);
+                    rgba[i * largeur + j0 + j].b = saturer(acc_b[j]);
+                }
+            }
+        }
+    }
+}
+
+#endif
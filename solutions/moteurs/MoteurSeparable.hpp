@@ -0,0 +1,92 @@
+#ifndef MOTEURSEPARABLE_HPP
+#define MOTEURSEPARABLE_HPP
+
+#include "Image.hpp"
+#include "Noyau.hpp"
+
+
+/**
+ * Produit de convolution en deux passes 1D par terme séparable :
+ * Filtre[ii, jj] = Sum_k(Colonne_k[ii] * Ligne_k[jj]), donc 2rK au lieu
+ * de K^2 multiplications par pixel et par canal - écrase l'image originale
+ */
+static void prod_conv_separable(LePNG & rgba, const Noyau & filtre)
+{
+    const int largeur = rgba.largeur();
+    const int hauteur = rgba.hauteur();
+    const int taille_filtre = filtre.largeur();
+    const int marge = (int)taille_filtre / 2;  // Type int (signé) nécessaire
+
+    const Image<double> im(rgba, marge);
+
+    std::cout << "Filtrage séparable en cours (" << filtre.rang()
+        << " terme(s)) ..." << std::endl;
+
+    // Résultat de la passe horizontale, avec les seules lignes de marge
+    // du haut et du bas
+    Image<double> horiz(largeur, hauteur + 2 * marge);
+
+    // Somme des passes verticales de chaque terme
+    Image<double> somme(largeur, hauteur);
+
+    for (Noyau::size_type k = 0; k < filtre.rang(); ++k) {
+        const std::vector<double> & ligne = filtre.ligne(k);
+        const std::vector<double> & colonne = filtre.colonne(k);
+
+        // Passe horizontale sur toutes les lignes, marges du haut et du bas
+        // comprises : H[i, j] = Sum_jj(Im[i, j+jj] * Ligne[-jj])
+#pragma omp parallel for
+        for (int i = 0; i < hauteur + 2 * marge; ++i) {
+            const double * lig_r = im.ligne(0, i - marge);
+            const double * lig_g = im.ligne(1, i - marge);
+            const double * lig_b = im.ligne(2, i - marge);
+            double * h_r = horiz.ligne(0, i);
+            double * h_g = horiz.ligne(1, i);
+            double * h_b = horiz.ligne(2, i);
+
+            for (int j = 0; j < largeur; ++j) {
+                double r = 0.;
+                double g = 0.;
+                double b = 0.;
+
+#pragma omp simd reduction(+:r,g,b)
+                for (int jj = -marge; jj <= marge; ++jj) {
+                    r += lig_r[j + jj] * ligne[marge - jj];
+                    g += lig_g[j + jj] * ligne[marge - jj];
+                    b += lig_b[j + jj] * ligne[marge - jj];
+                }
+
+                h_r[j] = r;
+                h_g[j] = g;
+                h_b[j] = b;
+            }
+        }
+
+        // Passe verticale : S[i, j] += Sum_ii(H[i+ii, j] * Colonne[-ii])
+#pragma omp parallel for
+        for (int i = 0; i < hauteur; ++i) {
+            double * acc_r = somme.ligne(0, i);
+            double * acc_g = somme.ligne(1, i);
+            double * acc_b = somme.ligne(2, i);
+
+            for (int ii = -marge; ii <= marge; ++ii) {
+                const double * h_r = horiz.ligne(0, marge + i + ii);
+                const double * h_g = horiz.ligne(1, marge + i + ii);
+                const double * h_b = horiz.ligne(2, marge + i + ii);
+                const double poids = colonne[marge - ii];
+
+#pragma omp simd
+                for (int j = 0; j < largeur; ++j) {
+                    acc_r[j] += h_r[j] * poids;
+                    acc_g[j] += h_g[j] * poids;
+                    acc_b[j] += h_b[j] * poids;
+                }
+            }
+        }
+    }
+
+    // Placer le résultat dans l'image originale
+    somme.copier_vers(rgba);
+}
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef MOTEURSOMMESCUMULEES_HPP
+#define MOTEURSOMMESCUMULEES_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "Image.hpp"
+#include "Noyau.hpp"
+
+
+/**
+ * Produit de convolution par table de sommes cumulées (summed-area table)
+ * pour un noyau constant par rectangles - écrase l'image originale
+ *
+ * Avec les coins D du noyau (voir Noyau::coins()) :
+ * Prod_conv[i, j] = Sum(D[p, q] * Somme(Im, lignes i-m+p..i+m,
+ *                                           colonnes j-m+q..j+m)),
+ * où chaque somme rectangulaire coûte 4 lectures de la table. Le coût par
+ * pixel ne dépend donc pas de K : 4 lectures pour une boîte.
+ */
+static void prod_conv_sommes_cumulees(LePNG & rgba, const Noyau & filtre)
+{
+    const int largeur = rgba.largeur();
+    const int hauteur = rgba.hauteur();
+    const int taille_filtre = filtre.largeur();
+    const int marge = (int)taille_filtre / 2;  // Type int (signé) nécessaire
+    const std::vector<Coefficient> & coins = filtre.coins();
+
+    const Image<png_byte> im(rgba, marge);
+
+    std::cout << "Filtrage par sommes cumulées en cours (" << coins.size()
+        << " coin(s)) ..." << std::endl;
+
+    // S[i, j] = Sum(Im[ii, jj], ii < i, jj < j), exacte en entiers 64 bits ;
+    // tailles et indices en size_t, sans débordement pour les grandes images
+    const int hauteur_s = hauteur + 2 * marge + 1;
+    const size_t largeur_s = largeur + 2 * marge + 1;
+    std::vector<int64_t> s((size_t)hauteur_s * largeur_s);
+
+    for (int c = 0; c < 3; ++c) {
+        // Sommes par ligne en parallèle, puis cumul vertical par colonne
+#pragma omp parallel for
+        for (int i = 0; i < hauteur_s; ++i) {
+            int64_t * ligne_s = &s[i * largeur_s];
+
+            // Ligne 0 : aucune ligne de l'image au-dessus
+            if (i == 0) {
+                std::fill(ligne_s, ligne_s + largeur_s, 0);
+                continue;
+            }
+
+            const png_byte * p = im.ligne(c, i - 1 - marge) - 1 - marge;
+            int64_t somme = 0;
+            ligne_s[0] = 0;
+            for (size_t j = 1; j < largeur_s; ++j) {
+                somme += p[j];
+                ligne_s[j] = somme;
+            }
+        }
+
+#pragma omp parallel
+        for (int i = 1; i < hauteur_s; ++i) {
+#pragma omp for
+            for (size_t j = 0; j < largeur_s; ++j)
+                s[i * largeur_s + j] += s[(i - 1) * largeur_s + j];
+        }
+
+        // Somme du rectangle de coins (i0, j0) inclus et (i1, j1) exclus
+        #define RECT(i0, j0, i1, j1) (double)(s[(i1) * largeur_s + (j1)] \
+            - s[(i0) * largeur_s + (j1)] - s[(i1) * largeur_s + (j0)] \
+            + s[(i0) * largeur_s + (j0)])
+
+#pragma omp parallel for
+        for (int i = 0; i < hauteur; ++i) {
+            for (int j = 0; j < largeur; ++j) {
+                double v = 0.;
+
+                for (size_t k = 0; k < coins.size(); ++k)
+                    v += coins[k].poids * RECT(i + coins[k].di,
+                        j + coins[k].dj, i + taille_filtre, j + taille_filtre);
+
+                // Placer le résultat dans l'image originale
+                png_byte * p = &rgba[i * largeur + j].r;
+                p[c] = saturer(v);
+            }
+        }
+
+        #undef RECT
+    }
+}
+
+#endif
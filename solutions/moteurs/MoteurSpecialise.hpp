@@ -0,0 +1,108 @@
+#ifndef MOTEURSPECIALISE_HPP
+#define MOTEURSPECIALISE_HPP
+
+#include "Image.hpp"
+#include "MoteurDirect.hpp"
+#include "Noyau.hpp"
+
+
+/**
+ * Produit de convolution direct pour une taille de noyau K connue à la
+ * compilation : boucles internes entièrement déroulées, coefficients en
+ * registres et vectorisation selon j - écrase l'image originale
+ */
+template <int K>
+static void prod_conv_fixe(LePNG & rgba, const Noyau & filtre)
+{
+    const int largeur = rgba.largeur();
+    const int hauteur = rgba.hauteur();
+    const int marge = K / 2;
+
+    const Image<double> im(rgba, marge);
+    const int stride = im.stride();
+
+    std::cout << "Filtrage direct spécialisé (K = " << K << ") en cours ..."
+        << std::endl;
+
+    // Noyau retourné : poids[ii][jj] = Filtre[-ii, -jj]
+    double poids[K][K];
+    for (int ii = 0; ii < K; ++ii)
+        for (int jj = 0; jj < K; ++jj)
+            poids[ii][jj] = filtre[(K - 1 - ii) * K + (K - 1 - jj)];
+
+#pragma omp parallel
+    {
+        Image<double> lig(largeur, 1);
+        double * lig_r = lig.ligne(0, 0);
+        double * lig_g = lig.ligne(1, 0);
+        double * lig_b = lig.ligne(2, 0);
+
+#pragma omp for
+        for (int i = 0; i < hauteur; ++i) {
+            // Coin supérieur gauche de la fenêtre du pixel (i, 0)
+            const double * im_r = im.ligne(0, i - marge) - marge;
+            const double * im_g = im.ligne(1, i - marge) - marge;
+            const double * im_b = im.ligne(2, i - marge) - marge;
+
+#pragma omp simd
+            for (int j = 0; j < largeur; ++j) {
+                double r = 0.;
+                double g = 0.;
+                double b = 0.;
+
+                for (int ii = 0; ii < K; ++ii) {
+                    for (int jj = 0; jj < K; ++jj) {
+                        r += im_r[ii * stride + j + jj] * poids[ii][jj];
+                        g += im_g[ii * stride + j + jj] * poids[ii][jj];
+                        b += im_b[ii * stride + j + jj] * poids[ii][jj];
+                    }
+                }
+
+                lig_r[j] = r;
+                lig_g[j] = g;
+                lig_b[j] = b;
+            }
+
+            // Placer le résultat dans l'image originale
+            for (int j = 0; j < largeur; ++j) {
+                rgba[i * largeur + j].r = saturer(lig_r[j]);
+                rgba[i * largeur + j].g = saturer(lig_g[j]);
+                rgba[i * largeur + j].b = saturer(lig_b[j]);
+            }
+        }
+    }
+}
+
+
+/**
+ * Vrai si prod_conv_fixe() est instanciée pour cette taille de noyau
+ */
+static inline bool taille_specialisee(int taille_filtre)
+{
+    switch (taille_filtre) {
+        case 3: case 5: case 7: case 9: case 11: case 13: case 15:
+            return true;
+        default:
+            return false;
+    }
+}
+
+
+/**
+ * Aiguillage vers prod_conv_fixe<K>(), sinon vers la boucle générique
+ */
+static void prod_conv_specialise(LePNG & rgba, const Noyau & filtre)
+{
+    switch (filtre.largeur()) {
+        case 3: prod_conv_fixe<3>(rgba, filtre); break;
+        case 5: prod_conv_fixe<5>(rgba, filtre); break;
+        case 7: prod_conv_fixe<7>(rgba, filtre); break;
+        case 9: prod_conv_fixe<9>(rgba, filtre); break;
+        case 11: prod_conv_fixe<11>(rgba, filtre); break;
+        case 13: prod_conv_fixe<13>(rgba, filtre); break;
+        case 15: prod_conv_fixe<15>(rgba, filtre); break;
+        default: prod_conv_direct(rgba, filtre);
+    }
+}
+
+#endif
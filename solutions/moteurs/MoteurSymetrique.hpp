@@ -0,0 +1,145 @@
+#ifndef MOTEURSYMETRIQUE_HPP
+#define MOTEURSYMETRIQUE_HPP
+
+#include <algorithm>
+#include <vector>
+
+#include "Image.hpp"
+#include "Noyau.hpp"
+
+
+/**
+ * Produit de convolution direct exploitant les symétries du noyau - écrase
+ * l'image originale
+ *
+ * Les pixels placés symétriquement partagent le même coefficient ; ils
+ * sont additionnés avant la multiplication :
+ * - symétrie haut-bas : R_t = Im[i+t] + Im[i-t], t = 0..marge ;
+ * - symétrie gauche-droite : C(t, u) = R_t[j+u] + R_t[j-u], u = 0..marge ;
+ * - symétrie diagonale (avec les deux autres) : C(t, u) + C(u, t), t < u.
+ * Un noyau à 8 axes coûte ainsi (m+1)(m+2)/2 multiplications au lieu de
+ * (2m+1)^2 par pixel et par canal.
+ */
+static void prod_conv_symetrique(LePNG & rgba, const Noyau & filtre)
+{
+    const int SEGMENT = 1024;
+
+    const int largeur = rgba.largeur();
+    const int hauteur = rgba.hauteur();
+    const int taille_filtre = filtre.largeur();
+    const int marge = (int)taille_filtre / 2;  // Type int (signé) nécessaire
+
+    const bool sym_h = filtre.symetries() & SYMETRIE_H;
+    const bool sym_v = filtre.symetries() & SYMETRIE_V;
+    const bool sym_d = sym_h && sym_v && (filtre.symetries() & SYMETRIE_D);
+
+    const Image<double> plans(rgba, marge);
+
+    std::cout << "Filtrage direct symétrique ("
+        << (sym_d ? "8 axes" : (sym_h && sym_v) ? "4 axes" :
+            sym_h ? "gauche-droite" : sym_v ? "haut-bas" : "aucune")
+        << ") en cours ..." << std::endl;
+
+    // W(t, u) : coefficient du pixel Im[i+t, j+u]
+    std::vector<double> poids(taille_filtre * taille_filtre);
+    for (int t = -marge; t <= marge; ++t)
+        for (int u = -marge; u <= marge; ++u)
+            poids[(marge + t) * taille_filtre + (marge + u)] =
+                filtre[(marge - t) * taille_filtre + (marge - u)];
+    #define W(t, u) poids[(marge + (t)) * taille_filtre + (marge + (u))]
+
+    // Lignes t = -marge..marge, ou t = 0..marge si repliées haut-bas
+    const int t_min = sym_v ? 0 : -marge;
+    const int largeur_seg = SEGMENT + 2 * marge;
+
+#pragma omp parallel
+    {
+        std::vector<double> replis(sym_v ? (marge + 1) * largeur_seg : 0);
+        std::vector<const double *> lignes(2 * marge + 1);
+        std::vector<double> acc(SEGMENT);
+
+#pragma omp for collapse(2)
+        for (int i = 0; i < hauteur; ++i) {
+            for (int c = 0; c < 3; ++c) {
+                for (int j0 = 0; j0 < largeur; j0 += SEGMENT) {
+                    const int n = std::min(SEGMENT, largeur - j0);
+                    const int n_seg = n + 2 * marge;
+
+                    // R_t[x] pointe sur Im[i+t, j0+x-marge]
+                    for (int t = t_min; t <= marge; ++t) {
+                        const double * haut =
+                            plans.ligne(c, i + t) + j0 - marge;
+
+                        if (sym_v && t > 0) {
+                            const double * bas =
+                                plans.ligne(c, i - t) + j0 - marge;
+                            double * r = &replis[t * largeur_seg];
+#pragma omp simd
+                            for (int x = 0; x < n_seg; ++x)
+                                r[x] = haut[x] + bas[x];
+                            lignes[marge + t] = r;
+                        }
+                        else {
+                            lignes[marge + t] = haut;
+                        }
+                    }
+
+                    std::fill(acc.begin(), acc.begin() + n, 0.);
+
+                    for (int t = t_min; t <= marge; ++t) {
+                        const double * r_t = lignes[marge + t] + marge;
+
+                        if (!sym_h) {
+                            for (int u = -marge; u <= marge; ++u) {
+                                const double w = W(t, u);
+#pragma omp simd
+                                for (int j = 0; j < n; ++j)
+                                    acc[j] += r_t[j + u] * w;
+                            }
+                            continue;
+                        }
+
+                        for (int u = sym_d ? t : 0; u <= marge; ++u) {
+                            const double w = W(t, u);
+                            const double * r_u = lignes[marge + u] + marge;
+
+                            if (u == 0) {
+#pragma omp simd
+                                for (int j = 0; j < n; ++j)
+                                    acc[j] += r_t[j] * w;
+                            }
+                            else if (!sym_d || t == u) {
+#pragma omp simd
+                                for (int j = 0; j < n; ++j)
+                                    acc[j] += (r_t[j + u] + r_t[j - u]) * w;
+                            }
+                            else if (t == 0) {
+                                // C(0, u) + C(u, 0) = R_0[j+u] + R_0[j-u] + R_u[j]
+#pragma omp simd
+                                for (int j = 0; j < n; ++j)
+                                    acc[j] += (r_t[j + u] + r_t[j - u]
+                                               + r_u[j]) * w;
+                            }
+                            else {
+#pragma omp simd
+                                for (int j = 0; j < n; ++j)
+                                    acc[j] += (r_t[j + u] + r_t[j - u]
+                                               + r_u[j + t] + r_u[j - t]) * w;
+                            }
+                        }
+                    }
+
+                    // Placer le résultat dans l'image originale
+                    for (int j = 0; j < n; ++j) {
+                        png_byte * p = &rgba[i * largeur + j0 + j].r;
+                        p[c] = saturer(acc[j]);
+                    }
+                }
+            }
+        }
+    }
+
+    #undef W
+}
+
+#endif
@@ -0,0 +1,256 @@
+#ifndef MOTEURTFR_HPP
+#define MOTEURTFR_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Image.hpp"
+#include "Noyau.hpp"
+#include "TFR.hpp"
+
+
+/**
+ * Produit de convolution par TFR de l'image avec marges en miroir
+ * - écrase l'image originale
+ *
+ * Le noyau étant réel, deux canaux réels partagent une même TFR complexe :
+ * TFR(R + iG) * TFR(F) = TFR(R * F) + i TFR(G * F). Le canal B, seul, passe
+ * par la TFR réelle (demi-spectre, deux lignes par TFR complexe).
+ */
+static void prod_conv_tfr(LePNG & rgba, const Noyau & filtre)
+{
+    const int largeur = rgba.largeur();
+    const int hauteur = rgba.hauteur();
+    const int taille_filtre = filtre.largeur();
+    const int marge = (int)taille_filtre / 2;  // Type int (signé) nécessaire
+
+    const Image<png_byte> im(rgba, marge);
+
+    // Sans repliement sur la zone utile : N >= hauteur + taille_filtre - 1
+    const TFR tfr_lig(TFR::taille_rapide(largeur + 2 * marge));
+    const TFR tfr_col(TFR::taille_rapide(hauteur + 2 * marge));
+    const int nx = tfr_lig.taille();
+    const int ny = tfr_col.taille();
+
+    std::cout << "Filtrage par TFR en cours (" << nx << " x " << ny
+        << ") ..." << std::endl;
+
+    // Spectre du noyau, placé dans le coin (0, 0)
+    std::vector<complexe> spectre(ny * nx, 0.);
+    for (int i = 0; i < taille_filtre; ++i)
+        for (int j = 0; j < taille_filtre; ++j)
+            spectre[i * nx + j] = filtre[i * taille_filtre + j];
+    tfr_2d(spectre, tfr_lig, tfr_col);
+
+    // Plans R + iG et B (réel) de l'image avec marges
+    std::vector<complexe> plan_rg(ny * nx, 0.);
+    std::vector<double> plan_b(ny * nx, 0.);
+    std::vector<complexe> spectre_b;
+    const int nh = nx / 2 + 1;
+#pragma omp parallel for
+    for (int i = 0; i < hauteur + 2 * marge; ++i) {
+        const png_byte * r = im.ligne(0, i - marge) - marge;
+        const png_byte * g = im.ligne(1, i - marge) - marge;
+        const png_byte * b = im.ligne(2, i - marge) - marge;
+
+        for (int j = 0; j < largeur + 2 * marge; ++j) {
+            plan_rg[i * nx + j] = complexe(r[j], g[j]);
+            plan_b[i * nx + j] = b[j];
+        }
+    }
+
+    tfr_2d(plan_rg, tfr_lig, tfr_col);
+    tfr_2d_reelle(plan_b, spectre_b, tfr_lig, tfr_col);
+
+    const double normalisation = 1. / ((double)nx * ny);
+#pragma omp parallel for
+    for (int i = 0; i < ny * nx; ++i)
+        plan_rg[i] *= spectre[i] * normalisation;
+#pragma omp parallel for
+    for (int i = 0; i < ny; ++i)
+        for (int k = 0; k < nh; ++k)
+            spectre_b[i * nh + k] *= spectre[i * nx + k] * normalisation;
+
+    tfr_2d(plan_rg, tfr_lig, tfr_col, true);
+    tfr_2d_reelle_inverse(spectre_b, plan_b, tfr_lig, tfr_col);
+
+    // Prod_conv[i, j] = Circ[i + taille_filtre - 1, j + taille_filtre - 1]
+#pragma omp parallel for
+    for (int i = 0; i < hauteur; ++i) {
+        for (int j = 0; j < largeur; ++j) {
+            const int index = (i + 2 * marge) * nx + (j + 2 * marge);
+
+            // Placer le résultat dans l'image originale
+            rgba[i * largeur + j].r = saturer(plan_rg[index].real());
+            rgba[i * largeur + j].g = saturer(plan_rg[index].imag());
+            rgba[i * largeur + j].b = saturer(plan_b[index]);
+        }
+    }
+}
+
+
+/**
+ * Coût, en papillons, des TFR pour des tuiles T x T : par tuile, 2 TFR 2D
+ * complexes et 2 réelles (une demi chacune), et une pour le noyau
+ */
+static double papillons_tuiles(int largeur, int hauteur, int taille_filtre,
+                               int t)
+{
+    const double utile = t - taille_filtre + 1;
+    const double tuiles =
+        std::ceil(largeur / utile) * std::ceil(hauteur / utile);
+
+    return (3. * tuiles + 1.) * t * (double)t * std::log2(t * (double)t);
+}
+
+
+/**
+ * Taille T des tuiles TFR minimisant le coût total ; T <= 1024 borne la
+ * mémoire de travail à 32 Mo par fil d'exécution
+ */
+static int taille_tuile_tfr(int largeur, int hauteur, int taille_filtre)
+{
+    const int t_max = std::min(1024, TFR::taille_rapide(
+        std::max(largeur, hauteur) + taille_filtre - 1));
+    int t_min = TFR::taille_rapide(2 * taille_filtre);
+
+    for (int t = t_min; t <= t_max; t = TFR::taille_rapide(t + 1)) {
+        if (papillons_tuiles(largeur, hauteur, taille_filtre, t) <
+                papillons_tuiles(largeur, hauteur, taille_filtre, t_min))
+            t_min = t;
+    }
+
+    return t_min;
+}
+
+
+/**
+ * Produit de convolution par TFR sur des tuiles T x T (overlap-save) de
+ * l'image avec marges - écrase l'image originale
+ *
+ * Chaque tuile produit (T - K + 1)^2 pixels ; le spectre du noyau est
+ * calculé une seule fois et la mémoire de travail se limite à un plan
+ * complexe T x T et à un plan réel et son demi-spectre par fil
+ * d'exécution.
+ */
+static void prod_conv_tfr_tuiles(LePNG & rgba, const Noyau & filtre)
+{
+    const int largeur = rgba.largeur();
+    const int hauteur = rgba.hauteur();
+    const int taille_filtre = filtre.largeur();
+    const int marge = (int)taille_filtre / 2;  // Type int (signé) nécessaire
+
+    const Image<png_byte> im(rgba, marge);
+
+    const int t = taille_tuile_tfr(largeur, hauteur, taille_filtre);
+    const int utile = t - taille_filtre + 1;
+    const int tuiles_x = (largeur + utile - 1) / utile;
+    const int tuiles_y = (hauteur + utile - 1) / utile;
+    const TFR tfr(t);
+
+    std::cout << "Filtrage par TFR en cours (" << tuiles_x * tuiles_y
+        << " tuiles de " << t << " x " << t << ") ..." << std::endl;
+
+    // Spectre du noyau, placé dans le coin (0, 0), normalisé
+    std::vector<complexe> spectre(t * t, 0.);
+    for (int i = 0; i < taille_filtre; ++i)
+        for (int j = 0; j < taille_filtre; ++j)
+            spectre[i * t + j] = filtre[i * taille_filtre + j];
+    tfr_2d(spectre, tfr, tfr);
+    for (int i = 0; i < t * t; ++i)
+        spectre[i] /= (double)t * t;
+
+#pragma omp parallel
+    {
+        std::vector<complexe> plan_rg(t * t);
+        std::vector<double> plan_b(t * t);
+        std::vector<complexe> spectre_b(t * (t / 2 + 1));
+        const int nh = t / 2 + 1;
+
+#pragma omp for schedule(dynamic)
+        for (int tuile = 0; tuile < tuiles_x * tuiles_y; ++tuile) {
+            const int i0 = (tuile / tuiles_x) * utile;
+            const int j0 = (tuile % tuiles_x) * utile;
+
+            // Entrée : lignes i0 .. i0+T-1 de l'image avec marges, complétées
+            // par des zéros au-delà (sorties correspondantes ignorées)
+            const Image<png_byte> fenetre =
+                im.vue(i0 - marge, j0 - marge, t, t);
+
+            for (int i = 0; i < t; ++i) {
+                const png_byte * r = fenetre.ligne(0, i);
+                const png_byte * g = fenetre.ligne(1, i);
+                const png_byte * b = fenetre.ligne(2, i);
+
+                for (int j = 0; j < t; ++j) {
+                    if (i0 + i < hauteur + 2 * marge &&
+                            j0 + j < largeur + 2 * marge) {
+                        plan_rg[i * t + j] = complexe(r[j], g[j]);
+                        plan_b[i * t + j] = b[j];
+                    }
+                    else {
+                        plan_rg[i * t + j] = 0.;
+                        plan_b[i * t + j] = 0.;
+                    }
+                }
+            }
+
+            tfr_2d(plan_rg, tfr, tfr);
+            tfr_2d_reelle(plan_b, spectre_b, tfr, tfr);
+
+            for (int i = 0; i < t * t; ++i)
+                plan_rg[i] *= spectre[i];
+            for (int i = 0; i < t; ++i)
+                for (int k = 0; k < nh; ++k)
+                    spectre_b[i * nh + k] *= spectre[i * t + k];
+
+            tfr_2d(plan_rg, tfr, tfr, true);
+            tfr_2d_reelle_inverse(spectre_b, plan_b, tfr, tfr);
+
+            // Placer la partie utile dans l'image originale
+            const int fin_i = std::min(utile, hauteur - i0);
+            const int fin_j = std::min(utile, largeur - j0);
+            for (int i = 0; i < fin_i; ++i) {
+                for (int j = 0; j < fin_j; ++j) {
+                    const int index = (i + 2 * marge) * t + (j + 2 * marge);
+                    png_rgba & p = rgba[(i0 + i) * largeur + (j0 + j)];
+
+                    p.r = saturer(plan_rg[index].real());
+                    p.g = saturer(plan_rg[index].imag());
+                    p.b = saturer(plan_b[index]);
+                }
+            }
+        }
+    }
+}
+
+
+/**
+ * Coût estimé du moteur TFR, dans l'unité du moteur direct qui coûte
+ * hauteur * largeur * K^2 multiplications-additions sur 3 canaux
+ */
+static double cout_tfr(int largeur, int hauteur, int taille_filtre)
+{
+    const double nx = TFR::taille_rapide(largeur + taille_filtre - 1);
+    const double ny = TFR::taille_rapide(hauteur + taille_filtre - 1);
+
+    // 4 TFR 2D de N log2(N) papillons : noyau, directe et inverse de R + iG,
+    // directe et inverse réelles de B (une demi chacune) ; constante mesurée
+    // contre le moteur direct sur exemple.png
+    return 1.3 * 4. * nx * ny * std::log2(nx * ny);
+}
+
+
+/**
+ * Coût estimé du moteur TFR par tuiles, dans la même unité
+ */
+static double cout_tfr_tuiles(int largeur, int hauteur, int taille_filtre)
+{
+    const int t = taille_tuile_tfr(largeur, hauteur, taille_filtre);
+
+    // Constante mesurée comme pour cout_tfr(), tuiles plus favorables au cache
+    return 1.0 * papillons_tuiles(largeur, hauteur, taille_filtre, t);
+}
+
+#endif
@@ -0,0 +1,371 @@
+#ifndef NOYAU_HPP
+#define NOYAU_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+
+
+/**
+ * Symétries d'un noyau, combinables (SYMETRIE_H | SYMETRIE_V : 4 axes ;
+ * les trois : 8 axes)
+ */
+enum Symetrie {
+    SYMETRIE_H = 1,  // Gauche-droite : Filtre[i, j] = Filtre[i, -j]
+    SYMETRIE_V = 2,  // Haut-bas : Filtre[i, j] = Filtre[-i, j]
+    SYMETRIE_D = 4   // Diagonale : Filtre[i, j] = Filtre[j, i]
+};
+
+
+/**
+ * Coefficient non nul d'un noyau : Prod_conv[i, j] += Im[i+di, j+dj] * poids
+ */
+struct Coefficient {
+    int di, dj;
+    double poids;
+};
+
+
+/**
+ * Classe facilitant la lecture d'un noyau de convolution (filtre) carré
+ */
+class Noyau: public std::vector<double>
+{
+public:
+    Noyau(): taille(0), sym(0), ecart_coef(0.) {}
+
+    /**
+     * Chargement du noyau à partir du fichier texte de format :
+     *
+     * taille
+     * valeur_0_0 valeur_0_1 ... valeur_0_taille-1
+     * ...
+     * valeur_taille-1_0 ... valeur_taille-1_taille-1
+     *
+     * La tolérance borne la somme des écarts absolus entre le noyau et sa
+     * factorisation ; l'écart sur un canal de sortie est au plus
+     * 255 * tolérance. Les coefficients de valeur absolue inférieure ou
+     * égale au seuil sont omis de la liste des coefficients().
+     */
+    void charger(const std::string & nom_fichier, double tolerance = 1e-4,
+                 double seuil = 0.) {
+        std::ifstream ifs;
+        ifs.open(nom_fichier.c_str());
+
+        if (!ifs.is_open())
+            throw nom_fichier + " - n'a pas pu être ouvert.";
+
+        ifs >> taille;
+
+        if ((taille < 3) || (255 < taille))
+            throw nom_fichier + " - taille de noyau invalide (<3 ou >255).";
+        if ((taille & 1) == 0)
+            throw nom_fichier + " - taille de noyau invalide (mod 2 = 0).";
+
+        resize(taille * taille);
+        auto itValeur = begin();
+
+        do {
+            ifs >> *itValeur++;
+        } while (ifs.good() && (itValeur != end()));
+
+        if (ifs.fail() || (itValeur != end()))
+            throw nom_fichier + " - il manque des valeurs dans le fichier.";
+
+        ifs.close();
+
+        analyser(tolerance);
+        lister_coefficients(seuil);
+        lister_coins();
+    }
+
+    /**
+     * Définition directe du noyau (par exemple composé d'autres noyaux),
+     * avec la même analyse qu'au chargement
+     */
+    void definir(size_type taille_, const std::vector<double> & valeurs,
+                 double tolerance = 1e-4, double seuil = 0.) {
+        taille = taille_;
+        assign(valeurs.begin(), valeurs.end());
+
+        analyser(tolerance);
+        lister_coefficients(seuil);
+        lister_coins();
+    }
+
+    inline size_type largeur() const { return taille; }
+
+    /**
+     * Nombre r de termes séparables tels que
+     * filtre[i * taille + j] ~= Sum_k(colonne(k)[i] * ligne(k)[j]),
+     * ou 0 si r passes séparables (2rK) ne coûtent pas moins que K^2
+     */
+    inline size_type rang() const { return vect_col.size(); }
+    inline const std::vector<double> & colonne(size_type k = 0) const {
+        return vect_col[k];
+    }
+    inline const std::vector<double> & ligne(size_type k = 0) const {
+        return vect_lig[k];
+    }
+
+    /**
+     * Combinaison de Symetrie respectée à la tolérance près
+     */
+    inline int symetries() const { return sym; }
+
+    /**
+     * Coefficients non nuls au-delà du seuil, et écart maximal qu'entraîne
+     * l'omission des autres sur un canal de sortie
+     */
+    inline const std::vector<Coefficient> & coefficients() const {
+        return coef;
+    }
+    inline double ecart_coefficients() const { return ecart_coef; }
+
+    /**
+     * Coins du noyau retourné G[a, b] = Filtre[K-1-a, K-1-b] : différences
+     * finies 2D D[a, b] = G[a, b] - G[a-1, b] - G[a, b-1] + G[a-1, b-1], de
+     * sorte que G[a, b] = Sum(D[p, q], p <= a, q <= b). Un noyau constant
+     * par rectangles n'a que quelques coins (un seul pour une boîte) ; la
+     * liste est vide s'il en a plus de COINS_MAX.
+     */
+    static const size_type COINS_MAX = 16;
+    inline const std::vector<Coefficient> & coins() const { return vect_coins; }
+
+private:
+    /**
+     * Somme des écarts absolus entre le noyau et ses r premiers termes
+     */
+    double ecart(size_type r) const {
+        const Noyau & filtre = *this;
+        double somme = 0.;
+
+        for (size_type i = 0; i < taille; ++i) {
+            for (size_type j = 0; j < taille; ++j) {
+                double v = filtre[i * taille + j];
+                for (size_type k = 0; k < r; ++k)
+                    v -= vect_col[k][i] * vect_lig[k][j];
+                somme += std::fabs(v);
+            }
+        }
+
+        return somme;
+    }
+
+    /**
+     * Détection d'un noyau de rang 1 : le pivot de plus grande valeur
+     * absolue donne une colonne et une ligne dont le produit extérieur
+     * doit reproduire le noyau à la tolérance près.
+     */
+    bool factoriser_rang_1(double tolerance) {
+        const Noyau & filtre = *this;
+        size_type p = 0, q = 0;
+
+        for (size_type i = 0; i < taille; ++i)
+            for (size_type j = 0; j < taille; ++j)
+                if (std::fabs(filtre[i * taille + j]) >
+                        std::fabs(filtre[p * taille + q])) {
+                    p = i;
+                    q = j;
+                }
+
+        const double pivot = filtre[p * taille + q];
+        if (pivot == 0.)
+            return false;
+
+        vect_col.assign(1, std::vector<double>(taille));
+        vect_lig.assign(1, std::vector<double>(taille));
+
+        for (size_type i = 0; i < taille; ++i)
+            vect_col[0][i] = filtre[i * taille + q] / pivot;
+        for (size_type j = 0; j < taille; ++j)
+            vect_lig[0][j] = filtre[p * taille + j];
+
+        if (ecart(1) <= tolerance)
+            return true;
+
+        vect_col.clear();
+        vect_lig.clear();
+        return false;
+    }
+
+    /**
+     * Décomposition en valeurs singulières tronquée (Jacobi à un côté) :
+     * on garde le plus petit r respectant la tolérance, pourvu que 2r < K.
+     */
+    void factoriser_svd(double tolerance) {
+        const Noyau & filtre = *this;
+        const size_type n = taille;
+
+        // Colonnes de U (initialement celles du noyau) et de V (identité)
+        std::vector<std::vector<double> > u(n, std::vector<double>(n));
+        std::vector<std::vector<double> > v(n, std::vector<double>(n, 0.));
+        for (size_type j = 0; j < n; ++j) {
+            for (size_type i = 0; i < n; ++i)
+                u[j][i] = filtre[i * n + j];
+            v[j][j] = 1.;
+        }
+
+        for (int balayage = 0; balayage < 60; ++balayage) {
+            bool rotation = false;
+
+            for (size_type p = 0; p + 1 < n; ++p) {
+                for (size_type q = p + 1; q < n; ++q) {
+                    double alpha = 0., beta = 0., gamma = 0.;
+                    for (size_type i = 0; i < n; ++i) {
+                        alpha += u[p][i] * u[p][i];
+                        beta += u[q][i] * u[q][i];
+                        gamma += u[p][i] * u[q][i];
+                    }
+
+                    if (std::fabs(gamma) <= 1e-15 * std::sqrt(alpha * beta))
+                        continue;
+                    rotation = true;
+
+                    const double zeta = (beta - alpha) / (2. * gamma);
+                    const double t = (zeta >= 0. ? 1. : -1.) /
+                        (std::fabs(zeta) + std::sqrt(1. + zeta * zeta));
+                    const double c = 1. / std::sqrt(1. + t * t);
+                    const double s = c * t;
+
+                    for (size_type i = 0; i < n; ++i) {
+                        const double up = u[p][i], uq = u[q][i];
+                        u[p][i] = c * up - s * uq;
+                        u[q][i] = s * up + c * uq;
+                        const double vp = v[p][i], vq = v[q][i];
+                        v[p][i] = c * vp - s * vq;
+                        v[q][i] = s * vp + c * vq;
+                    }
+                }
+            }
+
+            if (!rotation)
+                break;
+        }
+
+        // Valeurs singulières = normes des colonnes de U, en ordre décroissant
+        std::vector<std::pair<double, size_type> > sigma(n);
+        for (size_type j = 0; j < n; ++j) {
+            double norme = 0.;
+            for (size_type i = 0; i < n; ++i)
+                norme += u[j][i] * u[j][i];
+            sigma[j] = std::make_pair(std::sqrt(norme), j);
+        }
+        std::sort(sigma.rbegin(), sigma.rend());
+
+        // Colonne(k) = sigma_k * u_k / ||u_k|| = u_k ; Ligne(k) = v_k
+        for (size_type r = 1; 2 * r < n; ++r) {
+            const size_type k = sigma[r - 1].second;
+            vect_col.push_back(u[k]);
+            vect_lig.push_back(v[k]);
+
+            if (ecart(r) <= tolerance)
+                return;
+        }
+
+        vect_col.clear();
+        vect_lig.clear();
+    }
+
+    /**
+     * Somme des écarts absolus entre le noyau et son image par une symétrie
+     */
+    double ecart_symetrie(Symetrie s) const {
+        const Noyau & filtre = *this;
+        double somme = 0.;
+
+        for (size_type i = 0; i < taille; ++i) {
+            for (size_type j = 0; j < taille; ++j) {
+                const size_type i2 = (s == SYMETRIE_V) ? taille - 1 - i :
+                    (s == SYMETRIE_D) ? j : i;
+                const size_type j2 = (s == SYMETRIE_H) ? taille - 1 - j :
+                    (s == SYMETRIE_D) ? i : j;
+                somme += std::fabs(
+                    filtre[i * taille + j] - filtre[i2 * taille + j2]);
+            }
+        }
+
+        return somme;
+    }
+
+    void lister_coefficients(double seuil) {
+        const Noyau & filtre = *this;
+        const int marge = taille / 2;
+
+        coef.clear();
+        ecart_coef = 0.;
+
+        for (int di = -marge; di <= marge; ++di) {
+            for (int dj = -marge; dj <= marge; ++dj) {
+                const Coefficient c = { di, dj,
+                    filtre[(marge - di) * taille + (marge - dj)] };
+
+                if (c.poids != 0. && std::fabs(c.poids) > seuil)
+                    coef.push_back(c);
+                else
+                    ecart_coef += 255. * std::fabs(c.poids);
+            }
+        }
+    }
+
+    void lister_coins() {
+        const Noyau & filtre = *this;
+        const int k = taille;
+        double max_abs = 0.;
+
+        for (size_type i = 0; i < size(); ++i)
+            max_abs = std::max(max_abs, std::fabs(filtre[i]));
+
+        vect_coins.clear();
+
+        for (int a = 0; a < k; ++a) {
+            for (int b = 0; b < k; ++b) {
+                #define G(a, b) (((a) < 0 || (b) < 0) ? 0. : \
+                    filtre[(k - 1 - (a)) * k + (k - 1 - (b))])
+                const double d = G(a, b) - G(a - 1, b) - G(a, b - 1)
+                    + G(a - 1, b - 1);
+                #undef G
+
+                if (std::fabs(d) > 1e-12 * max_abs) {
+                    if (vect_coins.size() == COINS_MAX) {
+                        vect_coins.clear();
+                        return;
+                    }
+                    const Coefficient c = { a, b, d };
+                    vect_coins.push_back(c);
+                }
+            }
+        }
+    }
+
+    void analyser(double tolerance) {
+        sym = 0;
+        if (ecart_symetrie(SYMETRIE_H) <= tolerance)
+            sym |= SYMETRIE_H;
+        if (ecart_symetrie(SYMETRIE_V) <= tolerance)
+            sym |= SYMETRIE_V;
+        if (ecart_symetrie(SYMETRIE_D) <= tolerance)
+            sym |= SYMETRIE_D;
+
+        vect_col.clear();
+        vect_lig.clear();
+
+        if (!factoriser_rang_1(tolerance))
+            factoriser_svd(tolerance);
+    }
+
+    size_type taille;
+    int sym;
+
+    std::vector<std::vector<double> > vect_col;
+    std::vector<std::vector<double> > vect_lig;
+
+    std::vector<Coefficient> coef;
+    double ecart_coef;
+
+    std::vector<Coefficient> vect_coins;
+};
+
+#endif
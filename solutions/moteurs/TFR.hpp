@@ -0,0 +1,393 @@
+#ifndef TFR_HPP
+#define TFR_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <vector>
+
+
+typedef std::complex<double> complexe;
+
+
+/**
+ * Transformée de Fourier rapide (TFR) 1D à radix mixte, de taille
+ * quelconque mais efficace pour les tailles de la forme 2^a 3^b 5^c
+ * https://fr.wikipedia.org/wiki/Algorithme_de_Cooley-Tukey
+ */
+class TFR
+{
+public:
+    explicit TFR(int n_): n(n_), twiddles(n_) {
+        for (int i = 0; i < n; ++i)
+            twiddles[i] = std::polar(1., -2. * M_PI * i / n);
+
+        // Facteurs (p, m) successifs tels que n = p_0 * m_0, m_0 = p_1 * m_1...
+        int reste = n;
+        for (int p = 4; reste > 1; ) {
+            if (reste % p == 0) {
+                reste /= p;
+                facteurs.push_back(p);
+                facteurs.push_back(reste);
+            }
+            else {
+                p = (p == 4) ? 2 : (p == 2) ? 3 : p + 2;
+            }
+        }
+    }
+
+    /**
+     * Plus petite taille >= n de la forme 2^a 3^b 5^c
+     */
+    static int taille_rapide(int n) {
+        for (;; ++n) {
+            int reste = n;
+            while (reste % 2 == 0) reste /= 2;
+            while (reste % 3 == 0) reste /= 3;
+            while (reste % 5 == 0) reste /= 5;
+            if (reste == 1)
+                return n;
+        }
+    }
+
+    inline int taille() const { return n; }
+
+    /**
+     * Transformée directe de entree[0], entree[pas], ... vers sortie[0..n)
+     */
+    void directe(const complexe * entree, complexe * sortie, int pas = 1) const {
+        if (n == 1)
+            sortie[0] = entree[0];
+        else
+            etape(sortie, entree, 1, pas, &facteurs[0]);
+    }
+
+private:
+    /**
+     * Étape récursive de décimation temporelle : sous-transformées de
+     * taille m, puis papillons de radix p
+     */
+    void etape(complexe * sortie, const complexe * f, int fpas, int pas,
+               const int * facteur) const {
+        const int p = facteur[0];
+        const int m = facteur[1];
+        complexe * const debut = sortie;
+        complexe * const fin = sortie + p * m;
+
+        if (m == 1) {
+            do {
+                *sortie = *f;
+                f += fpas * pas;
+            } while (++sortie != fin);
+        }
+        else {
+            do {
+                etape(sortie, f, fpas * p, pas, facteur + 2);
+                f += fpas * pas;
+            } while ((sortie += m) != fin);
+        }
+
+        switch (p) {
+            case 2: papillon_2(debut, fpas, m); break;
+            case 3: papillon_3(debut, fpas, m); break;
+            case 4: papillon_4(debut, fpas, m); break;
+            case 5: papillon_5(debut, fpas, m); break;
+            default: papillon(debut, fpas, m, p);
+        }
+    }
+
+    void papillon_2(complexe * sortie, int fpas, int m) const {
+        for (int k = 0; k < m; ++k) {
+            const complexe t = sortie[m + k] * twiddles[k * fpas];
+            sortie[m + k] = sortie[k] - t;
+            sortie[k] += t;
+        }
+    }
+
+    void papillon_3(complexe * sortie, int fpas, int m) const {
+        const double sin_3 = twiddles[fpas * m].imag();  // -sqrt(3) / 2
+
+        for (int k = 0; k < m; ++k) {
+            const complexe s1 = sortie[m + k] * twiddles[k * fpas];
+            const complexe s2 = sortie[2 * m + k] * twiddles[2 * k * fpas];
+            const complexe s3 = s1 + s2;
+            const complexe s0 = (s1 - s2) * sin_3;
+            const complexe a = sortie[k] - s3 * 0.5;
+
+            sortie[k] += s3;
+            sortie[m + k] = complexe(a.real() - s0.imag(), a.imag() + s0.real());
+            sortie[2 * m + k] =
+                complexe(a.real() + s0.imag(), a.imag() - s0.real());
+        }
+    }
+
+    void papillon_4(complexe * sortie, int fpas, int m) const {
+        for (int k = 0; k < m; ++k) {
+            const complexe s0 = sortie[m + k] * twiddles[k * fpas];
+            const complexe s1 = sortie[2 * m + k] * twiddles[2 * k * fpas];
+            const complexe s2 = sortie[3 * m + k] * twiddles[3 * k * fpas];
+            const complexe s5 = sortie[k] - s1;
+            const complexe s3 = s0 + s2;
+            const complexe s4 = s0 - s2;
+            const complexe s6 = sortie[k] + s1;
+
+            // Multiplication par -i pour la transformée directe
+            sortie[k] = s6 + s3;
+            sortie[2 * m + k] = s6 - s3;
+            sortie[m + k] = complexe(s5.real() + s4.imag(), s5.imag() - s4.real());
+            sortie[3 * m + k] =
+                complexe(s5.real() - s4.imag(), s5.imag() + s4.real());
+        }
+    }
+
+    void papillon_5(complexe * sortie, int fpas, int m) const {
+        const complexe ya = twiddles[fpas * m];
+        const complexe yb = twiddles[2 * fpas * m];
+
+        for (int k = 0; k < m; ++k) {
+            const complexe s0 = sortie[k];
+            const complexe s1 = sortie[m + k] * twiddles[k * fpas];
+            const complexe s2 = sortie[2 * m + k] * twiddles[2 * k * fpas];
+            const complexe s3 = sortie[3 * m + k] * twiddles[3 * k * fpas];
+            const complexe s4 = sortie[4 * m + k] * twiddles[4 * k * fpas];
+            const complexe s7 = s1 + s4, s10 = s1 - s4;
+            const complexe s8 = s2 + s3, s9 = s2 - s3;
+
+            const complexe s5 = s0 + s7 * ya.real() + s8 * yb.real();
+            const complexe s6(s10.imag() * ya.imag() + s9.imag() * yb.imag(),
+                              -s10.real() * ya.imag() - s9.real() * yb.imag());
+            const complexe s11 = s0 + s7 * yb.real() + s8 * ya.real();
+            const complexe s12(-s10.imag() * yb.imag() + s9.imag() * ya.imag(),
+                               s10.real() * yb.imag() - s9.real() * ya.imag());
+
+            sortie[k] = s0 + s7 + s8;
+            sortie[m + k] = s5 - s6;
+            sortie[4 * m + k] = s5 + s6;
+            sortie[2 * m + k] = s11 + s12;
+            sortie[3 * m + k] = s11 - s12;
+        }
+    }
+
+    void papillon(complexe * sortie, int fpas, int m, int p) const {
+        std::vector<complexe> temp(p);
+
+        for (int u = 0; u < m; ++u) {
+            for (int q = 0, k = u; q < p; ++q, k += m)
+                temp[q] = sortie[k];
+
+            for (int q1 = 0, k = u; q1 < p; ++q1, k += m) {
+                int tw = 0;
+                sortie[k] = temp[0];
+                for (int q = 1; q < p; ++q) {
+                    tw += fpas * k;
+                    if (tw >= n)
+                        tw -= n;
+                    sortie[k] += temp[q] * twiddles[tw];
+                }
+            }
+        }
+    }
+
+    const int n;
+    std::vector<complexe> twiddles;
+    std::vector<int> facteurs;
+};
+
+
+/**
+ * TFR 2D en place d'un plan de tfr_col.taille() lignes par
+ * tfr_lig.taille() colonnes : lignes puis colonnes. L'inverse n'est pas
+ * normalisée.
+ */
+static void tfr_2d(std::vector<complexe> & plan, const TFR & tfr_lig,
+                   const TFR & tfr_col, bool inverse = false)
+{
+    const int nx = tfr_lig.taille();
+    const int ny = tfr_col.taille();
+
+    // Inverse(x) = conj(Directe(conj(x)))
+    if (inverse) {
+#pragma omp parallel for
+        for (int i = 0; i < ny * nx; ++i)
+            plan[i] = std::conj(plan[i]);
+    }
+
+    // Colonnes traitées par blocs contigus pour limiter les défauts de cache
+    const int bloc = 8;
+
+#pragma omp parallel
+    {
+        std::vector<complexe> tampon(std::max(nx, ny));
+        std::vector<complexe> colonnes(bloc * ny);
+
+#pragma omp for
+        for (int i = 0; i < ny; ++i) {
+            tfr_lig.directe(&plan[i * nx], &tampon[0]);
+            std::copy(tampon.begin(), tampon.begin() + nx, &plan[i * nx]);
+        }
+
+#pragma omp for
+        for (int j0 = 0; j0 < nx; j0 += bloc) {
+            const int nb = std::min(bloc, nx - j0);
+
+            for (int i = 0; i < ny; ++i)
+                for (int b = 0; b < nb; ++b)
+                    colonnes[b * ny + i] = plan[i * nx + j0 + b];
+
+            for (int b = 0; b < nb; ++b) {
+                tfr_col.directe(&colonnes[b * ny], &tampon[0]);
+                std::copy(tampon.begin(), tampon.begin() + ny,
+                          &colonnes[b * ny]);
+            }
+
+            for (int i = 0; i < ny; ++i)
+                for (int b = 0; b < nb; ++b)
+                    plan[i * nx + j0 + b] = colonnes[b * ny + i];
+        }
+    }
+
+    if (inverse) {
+#pragma omp parallel for
+        for (int i = 0; i < ny * nx; ++i)
+            plan[i] = std::conj(plan[i]);
+    }
+}
+
+
+/**
+ * TFR 2D d'un plan réel de tfr_col.taille() lignes par tfr_lig.taille()
+ * colonnes : seules les colonnes 0 .. nx / 2 du spectre sont calculées, les
+ * autres s'en déduisant par symétrie hermitienne. Deux lignes réelles
+ * partagent une même TFR complexe, Z = TFR(a + ib), puis sont séparées par
+ * la même symétrie : A[k] = (Z[k] + conj(Z[-k])) / 2 et
+ * B[k] = (Z[k] - conj(Z[-k])) / 2i.
+ */
+static void tfr_2d_reelle(const std::vector<double> & plan,
+                          std::vector<complexe> & spectre,
+                          const TFR & tfr_lig, const TFR & tfr_col)
+{
+    const int nx = tfr_lig.taille();
+    const int ny = tfr_col.taille();
+    const int nh = nx / 2 + 1;
+
+    spectre.resize(ny * nh);
+
+    // Colonnes traitées par blocs contigus, comme pour tfr_2d()
+    const int bloc = 8;
+
+#pragma omp parallel
+    {
+        std::vector<complexe> z(std::max(nx, ny)), tampon(std::max(nx, ny));
+        std::vector<complexe> colonnes(bloc * ny);
+
+#pragma omp for
+        for (int a = 0; a < ny; a += 2) {
+            const int b = a + 1;
+
+            for (int j = 0; j < nx; ++j)
+                z[j] = complexe(plan[a * nx + j],
+                                (b < ny) ? plan[b * nx + j] : 0.);
+            tfr_lig.directe(&z[0], &tampon[0]);
+
+            for (int k = 0; k < nh; ++k) {
+                const complexe zk = tampon[k];
+                const complexe zm = std::conj(tampon[(nx - k) % nx]);
+
+                spectre[a * nh + k] = 0.5 * (zk + zm);
+                if (b < ny)
+                    spectre[b * nh + k] = complexe(0., -0.5) * (zk - zm);
+            }
+        }
+
+#pragma omp for
+        for (int j0 = 0; j0 < nh; j0 += bloc) {
+            const int nb = std::min(bloc, nh - j0);
+
+            for (int i = 0; i < ny; ++i)
+                for (int c = 0; c < nb; ++c)
+                    colonnes[c * ny + i] = spectre[i * nh + j0 + c];
+
+            for (int c = 0; c < nb; ++c) {
+                tfr_col.directe(&colonnes[c * ny], &tampon[0]);
+                std::copy(tampon.begin(), tampon.begin() + ny,
+                          &colonnes[c * ny]);
+            }
+
+            for (int i = 0; i < ny; ++i)
+                for (int c = 0; c < nb; ++c)
+                    spectre[i * nh + j0 + c] = colonnes[c * ny + i];
+        }
+    }
+}
+
+
+/**
+ * Inverse de tfr_2d_reelle(), non normalisée : après la TFR inverse des
+ * colonnes, chaque ligne du demi-spectre est la TFR d'une ligne réelle ;
+ * deux lignes sont alors reconstruites par une même TFR inverse complexe
+ * de Z = A + iB. Le demi-spectre est écrasé.
+ */
+static void tfr_2d_reelle_inverse(std::vector<complexe> & spectre,
+                                  std::vector<double> & plan,
+                                  const TFR & tfr_lig, const TFR & tfr_col)
+{
+    const int nx = tfr_lig.taille();
+    const int ny = tfr_col.taille();
+    const int nh = nx / 2 + 1;
+    const int bloc = 8;
+
+    plan.resize(ny * nx);
+
+#pragma omp parallel
+    {
+        std::vector<complexe> z(std::max(nx, ny)), tampon(std::max(nx, ny));
+        std::vector<complexe> colonnes(bloc * ny);
+
+        // Inverse(x) = conj(Directe(conj(x)))
+#pragma omp for
+        for (int j0 = 0; j0 < nh; j0 += bloc) {
+            const int nb = std::min(bloc, nh - j0);
+
+            for (int i = 0; i < ny; ++i)
+                for (int c = 0; c < nb; ++c)
+                    colonnes[c * ny + i] = std::conj(spectre[i * nh + j0 + c]);
+
+            for (int c = 0; c < nb; ++c) {
+                tfr_col.directe(&colonnes[c * ny], &tampon[0]);
+                std::copy(tampon.begin(), tampon.begin() + ny,
+                          &colonnes[c * ny]);
+            }
+
+            for (int i = 0; i < ny; ++i)
+                for (int c = 0; c < nb; ++c)
+                    spectre[i * nh + j0 + c] = std::conj(colonnes[c * ny + i]);
+        }
+
+#pragma omp for
+        for (int a = 0; a < ny; a += 2) {
+            const int b = a + 1;
+
+            // conj(Z[k]) = conj(A[k]) - i conj(B[k]), avec
+            // A[nx - k] = conj(A[k]) au-delà de nx / 2
+            for (int k = 0; k < nx; ++k) {
+                const bool miroir = k >= nh;
+                const int kk = miroir ? nx - k : k;
+                const complexe ak = miroir ? std::conj(spectre[a * nh + kk])
+                                           : spectre[a * nh + kk];
+                const complexe bk = (b >= ny) ? complexe(0.) : miroir ?
+                    std::conj(spectre[b * nh + kk]) : spectre[b * nh + kk];
+
+                z[k] = std::conj(ak + complexe(0., 1.) * bk);
+            }
+            tfr_lig.directe(&z[0], &tampon[0]);
+
+            for (int j = 0; j < nx; ++j) {
+                plan[a * nx + j] = tampon[j].real();
+                if (b < ny)
+                    plan[b * nx + j] = -tampon[j].imag();
+            }
+        }
+    }
+}
+
+#endif
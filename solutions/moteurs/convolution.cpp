@@ -0,0 +1,899 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+#include "LePNG.hpp"
+#include "Noyau.hpp"
+#include "MoteurAxpy.hpp"
+#include "MoteurBanque.hpp"
+#include "MoteurBlocs.hpp"
+#include "MoteurBordure.hpp"
+#include "MoteurCreux.hpp"
+#include "MoteurDecimation.hpp"
+#include "MoteurDirect.hpp"
+#include "MoteurEntier.hpp"
+#include "MoteurFlux.hpp"
+#include "MoteurIncremental.hpp"
+#include "MoteurOctets.hpp"
+#include "MoteurPipeline.hpp"
+#include "MoteurRecursif.hpp"
+#include "MoteurSeparable.hpp"
+#include "MoteurSIMD.hpp"
+#include "MoteurSommesCumulees.hpp"
+#include "MoteurSpecialise.hpp"
+#include "MoteurSymetrique.hpp"
+#include "MoteurTFR.hpp"
+
+
+/**
+ * Signature commune des moteurs de convolution
+ */
+typedef void (*Moteur)(LePNG & rgba, const Noyau & filtre);
+
+
+/**
+ * Sélection du moteur à partir de son nom ; "auto" choisit le moteur au
+ * plus faible coût estimé, en multiplications-additions de la boucle
+ * directe de référence
+ */
+static Moteur choisir_moteur(std::string & nom, const LePNG & rgba,
+                             const Noyau & filtre)
+{
+    if (nom == "auto") {
+        const double k = filtre.largeur();
+        const double pixels = (double)rgba.largeur() * rgba.hauteur();
+        // Blocs de registres : environ 5 fois la boucle directe (mesuré) ;
+        // le noyau 3 x 3 entièrement déroulé fait à peine mieux, et un
+        // noyau symétrique sur 4 axes réduit d'autant les multiplications
+        double cout_min = 0.2 * pixels * k * k;
+        const int sym_4 = SYMETRIE_H | SYMETRIE_V;
+
+        nom = (k <= 3) ? "specialise" :
+            ((filtre.symetries() & sym_4) == sym_4) ? "symetrique" : "blocs";
+
+        // Parcours axpy des seuls coefficients retenus : environ 2 fois la
+        // boucle directe (mesuré)
+        const double nnz = filtre.coefficients().size();
+        if (0.5 * pixels * nnz < cout_min) {
+            nom = "creux";
+            cout_min = 0.5 * pixels * nnz;
+        }
+        if (filtre.rang() > 0 && 2. * filtre.rang() * k * pixels < cout_min) {
+            nom = "separable";
+            cout_min = 2. * filtre.rang() * k * pixels;
+        }
+        // Sommes cumulées : construction de la table et 4 lectures par coin
+        const double coins = filtre.coins().size();
+        if (coins > 0 && pixels * (2. + 4. * coins) < cout_min) {
+            nom = "sommes";
+            cout_min = pixels * (2. + 4. * coins);
+        }
+        if (cout_tfr(rgba.largeur(), rgba.hauteur(), k) < cout_min) {
+            nom = "fft";
+            cout_min = cout_tfr(rgba.largeur(), rgba.hauteur(), k);
+        }
+        if (cout_tfr_tuiles(rgba.largeur(), rgba.hauteur(), k) < cout_min)
+            nom = "fft_tuiles";
+    }
+
+    if (nom == "direct")
+        return prod_conv_direct;
+    if (nom == "specialise")
+        return prod_conv_specialise;
+    if (nom == "blocs")
+        return prod_conv_blocs;
+    if (nom == "axpy")
+        return prod_conv_axpy;
+    if (nom == "entier") {
+        NoyauEntier quant(filtre);  // Lance une erreur si non représentable
+        return prod_conv_entier;
+    }
+    if (nom == "simd")
+        return prod_conv_simd;
+    if (nom == "octets")
+        return prod_conv_octets;
+    if (nom == "symetrique")
+        return prod_conv_symetrique;
+    if (nom == "creux")
+        return prod_conv_creux;
+    if (nom == "iir")
+        return prod_conv_recursif;
+    if (nom == "sommes") {
+        if (filtre.coins().empty())
+            throw std::string("le noyau n'est pas constant par rectangles.");
+        return prod_conv_sommes_cumulees;
+    }
+    if (nom == "separable") {
+        if (filtre.rang() == 0)
+            throw std::string("le noyau n'a pas de décomposition séparable"
+                " avantageuse à cette tolérance.");
+        return prod_conv_separable;
+    }
+    if (nom == "fft")
+        return prod_conv_tfr;
+    if (nom == "fft_tuiles")
+        return prod_conv_tfr_tuiles;
+
+    throw "moteur inconnu (" + nom + ").";
+}
+
+
+/**
+ * Écart maximal, tous canaux confondus, entre deux images
+ */
+static int ecart_max(const LePNG & a, const LePNG & b)
+{
+    int ecart = 0;
+
+    for (LePNG::size_type i = 0; i < a.size(); ++i) {
+        ecart = std::max(ecart, std::abs((int)a[i].r - (int)b[i].r));
+        ecart = std::max(ecart, std::abs((int)a[i].g - (int)b[i].g));
+        ecart = std::max(ecart, std::abs((int)a[i].b - (int)b[i].b));
+    }
+
+    return ecart;
+}
+
+
+/**
+ * Nom de fichier de résultat pour un noyau du banc de filtres :
+ * resultat_<nom du fichier noyau>.png
+ */
+static std::string nom_resultat_banque(const std::string & nom_noyau)
+{
+    const std::string::size_type barre = nom_noyau.find_last_of('/');
+    return "resultat_" + ((barre == std::string::npos) ?
+        nom_noyau : nom_noyau.substr(barre + 1)) + ".png";
+}
+
+
+/**
+ * Mode banc de filtres : chaque noyau donné produit son propre résultat
+ */
+static int executer_banque(const LePNG & png, char * noms[], int nb_noyaux,
+                           double tolerance, double seuil, bool verifier)
+{
+    std::vector<Noyau> noyaux(nb_noyaux);
+
+    try {
+        for (int k = 0; k < nb_noyaux; ++k)
+            noyaux[k].charger(noms[k], tolerance, seuil);
+    }
+    catch (const std::string message) {
+        std::cerr << "Erreur: " << message << std::endl;
+        return 3;
+    }
+
+    std::vector<LePNG> resultats;
+
+    auto debut = std::chrono::steady_clock::now();
+    prod_conv_banque(png, noyaux, resultats);
+    std::chrono::duration<double> duree =
+        std::chrono::steady_clock::now() - debut;
+    std::cout << "Moteur banque : " << duree.count() << " s" << std::endl;
+
+    for (int k = 0; k < nb_noyaux; ++k) {
+        if (verifier) {
+            LePNG reference(png);
+            prod_conv_direct(reference, noyaux[k]);
+            std::cout << "Écart maximal avec le moteur direct (" << noms[k]
+                << ") : " << ecart_max(resultats[k], reference) << std::endl;
+        }
+
+        try {
+            const std::string fichier_resultat = nom_resultat_banque(noms[k]);
+            resultats[k].enregistrer(fichier_resultat);
+
+            std::cout << "L'image a été filtrée et enregistrée dans "
+                << fichier_resultat << " avec succès!" << std::endl;
+        }
+        catch (const std::string message) {
+            std::cerr << "Erreur: " << message << std::endl;
+            return 4;
+        }
+    }
+
+    return 0;
+}
+
+
+/**
+ * Noms des noyaux d'une chaîne "noyau1,noyau2,..."
+ */
+static std::vector<std::string> decouper_chaine(const std::string & noms)
+{
+    std::vector<std::string> morceaux;
+    std::string::size_type debut = 0, virgule;
+
+    while ((virgule = noms.find(',', debut)) != std::string::npos) {
+        morceaux.push_back(noms.substr(debut, virgule - debut));
+        debut = virgule + 1;
+    }
+    morceaux.push_back(noms.substr(debut));
+
+    return morceaux;
+}
+
+
+/**
+ * Référence de la chaîne sans saturation intermédiaire : chaque étape est
+ * un produit direct en double précision sur le résultat miroité de la
+ * précédente, sans tuiles
+ */
+static void reference_pipeline(LePNG & rgba, const std::vector<Noyau> & etapes)
+{
+    const int largeur = rgba.largeur();
+    const int hauteur = rgba.hauteur();
+    const size_t n = (size_t)largeur * hauteur;
+
+    std::vector<double> plan(3 * n), suivant(3 * n);
+    for (size_t p = 0; p < n; ++p)
+        for (int c = 0; c < 3; ++c)
+            plan[c * n + p] = (&rgba[p].r)[c];
+
+    for (size_t s = 0; s < etapes.size(); ++s) {
+        const Noyau & filtre = etapes[s];
+        const int taille_filtre = filtre.largeur();
+        const int marge = taille_filtre / 2;
+
+#pragma omp parallel for
+        for (int i = 0; i < hauteur; ++i) {
+            for (int j = 0; j < largeur; ++j) {
+                for (int c = 0; c < 3; ++c) {
+                    double v = 0.;
+                    for (int ii = -marge; ii <= marge; ++ii) {
+                        const double * ligne =
+                            &plan[c * n + (size_t)miroir(i + ii, hauteur) * largeur];
+                        for (int jj = -marge; jj <= marge; ++jj)
+                            v += ligne[miroir(j + jj, largeur)] * filtre[
+                                (marge - ii) * taille_filtre + (marge - jj)];
+                    }
+                    suivant[c * n + (size_t)i * largeur + j] = v;
+                }
+            }
+        }
+
+        plan.swap(suivant);
+    }
+
+    for (size_t p = 0; p < n; ++p)
+        for (int c = 0; c < 3; ++c)
+            (&rgba[p].r)[c] = saturer(plan[c * n + p]);
+}
+
+
+/**
+ * Mode chaîne fusionnée : les étapes sont appliquées tuile par tuile, les
+ * résultats intermédiaires restant en simple précision. Avec saturer_etapes,
+ * chacun est saturé comme autant d'exécutions séparées.
+ */
+static int executer_pipeline(LePNG & png, const std::vector<Noyau> & etapes,
+                             bool saturer_etapes, bool verifier,
+                             const std::string & fichier_resultat)
+{
+    LePNG * reference = verifier ? new LePNG(png) : NULL;
+
+    auto debut = std::chrono::steady_clock::now();
+    prod_conv_pipeline(png, etapes, saturer_etapes);
+    std::chrono::duration<double> duree =
+        std::chrono::steady_clock::now() - debut;
+    std::cout << "Moteur pipeline : " << duree.count() << " s" << std::endl;
+
+    if (reference) {
+        if (saturer_etapes) {
+            for (size_t s = 0; s < etapes.size(); ++s)
+                prod_conv_direct(*reference, etapes[s]);
+        }
+        else {
+            reference_pipeline(*reference, etapes);
+        }
+        std::cout << "Écart maximal avec le calcul direct par étapes : "
+            << ecart_max(png, *reference) << std::endl;
+        delete reference;
+    }
+
+    try {
+        png.enregistrer(fichier_resultat);
+
+        std::cout << "L'image a été filtrée et enregistrée dans "
+            << fichier_resultat << " avec succès!" << std::endl;
+    }
+    catch (const std::string message) {
+        std::cerr << "Erreur: " << message << std::endl;
+        return 4;
+    }
+
+    return 0;
+}
+
+
+/**
+ * Mode incrémental : seules les régions de l'image qui diffèrent de
+ * l'image précédente sont refiltrées dans le résultat précédent
+ */
+static int executer_incremental(const LePNG & png, const Noyau & noyau,
+                                const std::string & precedents, bool verifier,
+                                const std::string & fichier_resultat)
+{
+    const std::vector<std::string> noms = decouper_chaine(precedents);
+    LePNG precedente, sortie;
+    std::vector<Rectangle> changements;
+
+    try {
+        if (noms.size() != 2)
+            throw std::string("-i attend image_precedente.png,"
+                "resultat_precedent.png.");
+        precedente.charger(noms[0]);
+        sortie.charger(noms[1]);
+        changements = detecter_changements(precedente, png);
+        if (sortie.largeur() != png.largeur() ||
+            sortie.hauteur() != png.hauteur())
+            throw std::string("le résultat précédent n'a pas les dimensions"
+                " de l'image.");
+    }
+    catch (const std::string message) {
+        std::cerr << "Erreur: " << message << std::endl;
+        return 2;
+    }
+
+    auto debut = std::chrono::steady_clock::now();
+    prod_conv_incremental(png, sortie, noyau, changements);
+    std::chrono::duration<double> duree =
+        std::chrono::steady_clock::now() - debut;
+    std::cout << "Moteur incremental : " << duree.count() << " s"
+        << std::endl;
+
+    if (verifier) {
+        LePNG reference(png);
+        prod_conv_direct(reference, noyau);
+
+        // L'alpha aussi doit suivre l'image courante
+        int ecart_alpha = 0;
+        for (LePNG::size_type i = 0; i < sortie.size(); ++i)
+            ecart_alpha = std::max(ecart_alpha,
+                std::abs((int)sortie[i].a - (int)reference[i].a));
+
+        std::cout << "Écart maximal avec le moteur direct : "
+            << ecart_max(sortie, reference) << " (alpha : " << ecart_alpha
+            << ")" << std::endl;
+    }
+
+    try {
+        sortie.enregistrer(fichier_resultat);
+
+        std::cout << "L'image a été filtrée et enregistrée dans "
+            << fichier_resultat << " avec succès!" << std::endl;
+    }
+    catch (const std::string message) {
+        std::cerr << "Erreur: " << message << std::endl;
+        return 4;
+    }
+
+    return 0;
+}
+
+
+/**
+ * Sous-échantillonnage d'un pas donné, pour la vérification du mode décimé
+ */
+static LePNG sous_echantillonner(const LePNG & rgba, int pas)
+{
+    LePNG resultat;
+    resultat.redimensionner(taille_decimee(rgba.largeur(), pas),
+                            taille_decimee(rgba.hauteur(), pas));
+
+    for (png_uint_32 i = 0; i < resultat.hauteur(); ++i) {
+        for (png_uint_32 j = 0; j < resultat.largeur(); ++j)
+            resultat[i * resultat.largeur() + j] =
+                rgba[i * pas * rgba.largeur() + j * pas];
+    }
+
+    return resultat;
+}
+
+
+/**
+ * Mode décimé : une seule image filtrée aux lignes et colonnes multiples
+ * de pas, ou une pyramide de niveaux (pas de 2 par niveau) enregistrés
+ * sous <resultat>_<niveau>.png
+ */
+static int executer_decimation(const LePNG & png, const Noyau & noyau,
+                               const std::string & nom_moteur, int pas,
+                               int nb_niveaux, bool verifier,
+                               const std::string & fichier_resultat)
+{
+    bool separable;
+    if (nom_moteur == "auto")
+        separable = noyau.rang() > 0;
+    else if (nom_moteur == "separable" && noyau.rang() > 0)
+        separable = true;
+    else if (nom_moteur == "direct")
+        separable = false;
+    else {
+        std::cerr << "Erreur: le mode décimé n'accepte que les moteurs"
+            " direct et separable (noyau de rang > 0)." << std::endl;
+        return 1;
+    }
+
+    std::vector<LePNG> niveaux;
+
+    auto debut = std::chrono::steady_clock::now();
+    if (nb_niveaux > 0) {
+        construire_pyramide(png, noyau, nb_niveaux, niveaux, separable);
+    }
+    else {
+        niveaux.assign(2, png);
+        if (separable)
+            prod_conv_decime_separable(niveaux[1], noyau, pas);
+        else
+            prod_conv_decime_direct(niveaux[1], noyau, pas);
+    }
+    std::chrono::duration<double> duree =
+        std::chrono::steady_clock::now() - debut;
+
+    // Niveau 0, l'original, n'est pas enregistré
+    if (niveaux.size() < 2) {
+        std::cerr << "Erreur: image trop petite pour un premier niveau"
+            " décimé avec ce noyau." << std::endl;
+        return 1;
+    }
+
+    std::cout << "Moteur " << (separable ? "separable" : "direct")
+        << " décimé : " << duree.count() << " s" << std::endl;
+
+    if (verifier) {
+        LePNG reference(png);
+        for (size_t n = 1; n < niveaux.size(); ++n) {
+            prod_conv_direct(reference, noyau);
+            reference = sous_echantillonner(reference, pas);
+            std::cout << "Écart maximal avec le moteur direct sous-échantillonné"
+                << " (niveau " << n << ") : "
+                << ecart_max(niveaux[n], reference) << std::endl;
+        }
+    }
+
+    const std::string::size_type point = fichier_resultat.rfind(".png");
+    const std::string base = (point == std::string::npos) ?
+        fichier_resultat : fichier_resultat.substr(0, point);
+
+    try {
+        for (size_t n = 1; n < niveaux.size(); ++n) {
+            const std::string nom = (nb_niveaux > 0) ?
+                base + "_" + std::to_string(n) + ".png" : fichier_resultat;
+            niveaux[n].enregistrer(nom);
+
+            std::cout << "L'image a été filtrée (" << niveaux[n].largeur()
+                << " x " << niveaux[n].hauteur() << ") et enregistrée dans "
+                << nom << " avec succès!" << std::endl;
+        }
+    }
+    catch (const std::string message) {
+        std::cerr << "Erreur: " << message << std::endl;
+        return 4;
+    }
+
+    return 0;
+}
+
+
+/**
+ * Mode flux : l'image est filtrée d'un fichier à l'autre sans jamais être
+ * entièrement chargée, en décodant, filtrant et encodant en parallèle si
+ * concurrent
+ */
+static int executer_flux(const std::string & fichier_image,
+                         const std::string & fichier_noyau,
+                         double tolerance, double seuil, bool verifier,
+                         bool concurrent,
+                         const std::string & fichier_resultat)
+{
+    Noyau noyau;
+
+    try {
+        noyau.charger(fichier_noyau, tolerance, seuil);
+    }
+    catch (const std::string message) {
+        std::cerr << "Erreur: " << message << std::endl;
+        return 3;
+    }
+
+    try {
+        auto debut = std::chrono::steady_clock::now();
+        if (concurrent)
+            prod_conv_flux_concurrent(fichier_image, fichier_resultat, noyau);
+        else
+            prod_conv_flux(fichier_image, fichier_resultat, noyau);
+        std::chrono::duration<double> duree =
+            std::chrono::steady_clock::now() - debut;
+        std::cout << "Moteur flux" << (concurrent ? " concurrent" : "")
+            << " (lecture et écriture comprises) : "
+            << duree.count() << " s" << std::endl;
+    }
+    catch (const std::string message) {
+        std::cerr << "Erreur: " << message << std::endl;
+        return 4;
+    }
+
+    if (verifier) {
+        LePNG reference, resultat;
+        try {
+            reference.charger(fichier_image);
+            resultat.charger(fichier_resultat);
+        }
+        catch (const std::string message) {
+            std::cerr << "Erreur: " << message << std::endl;
+            return 2;
+        }
+        prod_conv_direct(reference, noyau);
+        std::cout << "Écart maximal avec le moteur direct : "
+            << ecart_max(resultat, reference) << std::endl;
+    }
+
+    std::cout << "L'image a été filtrée et enregistrée dans "
+        << fichier_resultat << " avec succès!" << std::endl;
+
+    return 0;
+}
+
+
+/**
+ * Calcul de référence pour les politiques de bord autres que le miroir :
+ * copie explicite avec marges, remplies bloc par bloc sans remapper(), puis
+ * boucle directe. Pour le bord original, seul l'intérieur est filtré.
+ */
+static void reference_bordure(LePNG & rgba, const Noyau & filtre,
+                              PolitiqueBord politique, double constante)
+{
+    const int largeur = rgba.largeur();
+    const int hauteur = rgba.hauteur();
+    const int taille_filtre = filtre.largeur();
+    const int marge = (int)taille_filtre / 2;
+    const int l = largeur + 2 * marge;
+    const int h = hauteur + 2 * marge;
+
+    // pad[(c * h + i) * l + j], (i, j) = (marge, marge) au pixel (0, 0)
+    std::vector<double> pad(3 * (size_t)h * l, constante);
+    #define PAD(c, i, j) pad[((size_t)(c) * h + (i)) * l + (j)]
+
+    for (int c = 0; c < 3; ++c) {
+        for (int i = 0; i < hauteur; ++i)
+            for (int j = 0; j < largeur; ++j)
+                PAD(c, marge + i, marge + j) = (&rgba[i * largeur + j].r)[c];
+
+        if (politique == BORD_CONSTANT)
+            continue;
+
+        // Colonnes de gauche et de droite, de l'intérieur vers l'extérieur
+        for (int i = marge; i < marge + hauteur; ++i) {
+            for (int j = marge - 1; j >= 0; --j)
+                PAD(c, i, j) = (politique == BORD_CIRCULAIRE) ?
+                    PAD(c, i, j + largeur) : PAD(c, i, marge);
+            for (int j = marge + largeur; j < l; ++j)
+                PAD(c, i, j) = (politique == BORD_CIRCULAIRE) ?
+                    PAD(c, i, j - largeur) : PAD(c, i, marge + largeur - 1);
+        }
+
+        // Lignes du haut et du bas entières, marges comprises
+        for (int i = marge - 1; i >= 0; --i)
+            for (int j = 0; j < l; ++j)
+                PAD(c, i, j) = (politique == BORD_CIRCULAIRE) ?
+                    PAD(c, i + hauteur, j) : PAD(c, marge, j);
+        for (int i = marge + hauteur; i < h; ++i)
+            for (int j = 0; j < l; ++j)
+                PAD(c, i, j) = (politique == BORD_CIRCULAIRE) ?
+                    PAD(c, i - hauteur, j) : PAD(c, marge + hauteur - 1, j);
+    }
+
+#pragma omp parallel for
+    for (int i = 0; i < hauteur; ++i) {
+        for (int j = 0; j < largeur; ++j) {
+            if (politique == BORD_ORIGINAL &&
+                    (i < marge || i >= hauteur - marge ||
+                     j < marge || j >= largeur - marge))
+                continue;
+
+            for (int c = 0; c < 3; ++c) {
+                double v = 0.;
+                for (int ii = -marge; ii <= marge; ++ii)
+                    for (int jj = -marge; jj <= marge; ++jj)
+                        v += PAD(c, marge + i + ii, marge + j + jj) * filtre[
+                            (marge - ii) * taille_filtre + (marge - jj)];
+                (&rgba[i * largeur + j].r)[c] = saturer(v);
+            }
+        }
+    }
+
+    #undef PAD
+}
+
+
+/**
+ * Mode politique de bord : moteur sans copie avec marges, bords traités
+ * selon la politique donnée
+ */
+static int executer_bordure(LePNG & png, const Noyau & noyau,
+                            const std::string & nom_politique, bool verifier,
+                            const std::string & fichier_resultat)
+{
+    double constante = 0.;
+    PolitiqueBord politique;
+
+    try {
+        politique = lire_politique_bord(nom_politique, constante);
+    }
+    catch (const std::string message) {
+        std::cerr << "Erreur: " << message << std::endl;
+        return 1;
+    }
+
+    LePNG * reference = verifier ? new LePNG(png) : NULL;
+
+    auto debut = std::chrono::steady_clock::now();
+    prod_conv_bordure(png, noyau, politique, constante);
+    std::chrono::duration<double> duree =
+        std::chrono::steady_clock::now() - debut;
+    std::cout << "Moteur bordure : " << duree.count() << " s" << std::endl;
+
+    if (reference) {
+        // Le moteur direct applique le miroir ; les autres politiques sont
+        // comparées à une copie avec marges explicites
+        if (politique == BORD_MIROIR)
+            prod_conv_direct(*reference, noyau);
+        else
+            reference_bordure(*reference, noyau, politique, constante);
+        std::cout << "Écart maximal avec le calcul de référence : "
+            << ecart_max(png, *reference) << std::endl;
+        delete reference;
+    }
+
+    try {
+        png.enregistrer(fichier_resultat);
+
+        std::cout << "L'image a été filtrée et enregistrée dans "
+            << fichier_resultat << " avec succès!" << std::endl;
+    }
+    catch (const std::string message) {
+        std::cerr << "Erreur: " << message << std::endl;
+        return 4;
+    }
+
+    return 0;
+}
+
+
+static void usage(const char * nom)
+{
+    std::cerr << "Utilisation: " << nom
+        << " [-m moteur] [-t tolérance] [-z seuil] [-v] image.png"
+        << " fichier_noyau[,fichier_noyau...] [resultat.png]" << std::endl
+        << "       " << nom << " -s [-c] [-z seuil] [-v] image.png"
+        << " fichier_noyau,fichier_noyau... [resultat.png]" << std::endl
+        << "       " << nom << " -i precedente.png,resultat_precedent.png"
+        << " [-v] image.png fichier_noyau [resultat.png]" << std::endl
+        << "       " << nom << " -e politique [-v] image.png fichier_noyau"
+        << " [resultat.png]" << std::endl
+        << "       " << nom << " -f [-t tolérance] [-z seuil] [-v]"
+        << " image.png fichier_noyau [resultat.png]" << std::endl
+        << "       " << nom << " -d pas | -y niveaux [-m direct|separable]"
+        << " [-v] image.png fichier_noyau [resultat.png]" << std::endl
+        << "       " << nom << " -b [-z seuil] [-v] image.png fichier_noyau..."
+        << std::endl
+        << "  -m : auto (défaut), direct, specialise, blocs, axpy,"
+        << " entier, simd, octets, symetrique, creux, sommes, separable, fft,"
+        << " fft_tuiles, iir (approximation gaussienne, jamais choisie"
+        << " par auto)" << std::endl
+        << "  -t : tolérance de la décomposition du noyau en termes"
+        << " séparables (défaut 1e-4)" << std::endl
+        << "  -z : omettre les coefficients de valeur absolue <= seuil"
+        << " (défaut 0)" << std::endl
+        << "  -v : comparer le résultat au moteur direct" << std::endl
+        << "  -b : banc de filtres, un résultat resultat_<noyau>.png par"
+        << " noyau" << std::endl
+        << "Une chaîne de noyaux séparés par des virgules est composée en un"
+        << " seul noyau ;" << std::endl
+        << "  -s : appliquer plutôt les étapes fusionnées par tuiles, sans"
+        << " saturer les" << std::endl
+        << "       résultats intermédiaires" << std::endl
+        << "  -c : avec -s, saturer chaque résultat intermédiaire comme des"
+        << " exécutions séparées" << std::endl
+        << "  -i : ne refiltrer, dans le résultat précédent, que les régions"
+        << " qui diffèrent" << std::endl
+        << "       de l'image précédente" << std::endl
+        << "  -e : bords miroir, replique, circulaire, constante[=valeur]"
+        << " ou original," << std::endl
+        << "       sans copie avec marges" << std::endl
+        << "  -f : filtrer en flux, ligne par ligne, sans charger l'image"
+        << " entière" << std::endl
+        << "  -p : avec -f, décoder, filtrer et encoder en parallèle"
+        << std::endl
+        << "  -d : n'évaluer que les lignes et colonnes multiples de pas"
+        << std::endl
+        << "  -y : pyramide de niveaux (>= 2, l'original compris) décimés"
+        << " d'un pas de 2," << std::endl
+        << "       enregistrés sous resultat_<n>.png, n >= 1" << std::endl
+        << "Les moteurs simd et octets choisissent le jeu d'instructions à"
+        << " l'exécution ;"
+        << " CONVOLUTION_ISA=scalaire|sse42|avx2|avx512 le limite."
+        << std::endl;
+}
+
+
+/**
+ * Programme principal
+ */
+int main(int argc, char *argv[])
+{
+    LePNG png;
+    Noyau noyau;
+    std::string nom_moteur("auto");
+    double tolerance = 1e-4;
+    double seuil = 0.;
+    bool verifier = false;
+    bool banque = false;
+    bool fusionner = false;
+    bool saturer_etapes = false;
+    std::string precedents;
+    int pas = 1;
+    int nb_niveaux = 0;
+    bool flux = false;
+    bool concurrent = false;
+    std::string bord;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "m:t:z:vbsci:d:y:fpe:")) != -1) {
+        switch (opt) {
+            case 'm': nom_moteur = optarg; break;
+            case 't': tolerance = atof(optarg); break;
+            case 'z': seuil = atof(optarg); break;
+            case 'v': verifier = true; break;
+            case 'b': banque = true; break;
+            case 's': fusionner = true; break;
+            case 'c': saturer_etapes = true; break;
+            case 'i': precedents = optarg; break;
+            case 'd': pas = std::max(1, atoi(optarg)); break;
+            case 'y':
+                nb_niveaux = atoi(optarg);
+                pas = 2;
+                if (nb_niveaux < 2) {
+                    std::cerr << "Erreur: -y attend au moins 2 niveaux"
+                        " (l'original et un niveau décimé)." << std::endl;
+                    return 1;
+                }
+                break;
+            case 'f': flux = true; break;
+            case 'p': concurrent = true; break;
+            case 'e': bord = optarg; break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+
+    if (argc - optind < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (flux) {
+        return executer_flux(argv[optind], argv[optind + 1], tolerance, seuil,
+            verifier, concurrent, (argc - optind >= 3) ? argv[optind + 2] : "resultat.png");
+    }
+
+    try {
+        // Charger l'image originale
+        std::string nom_fichier_png(argv[optind]);
+        png.charger(nom_fichier_png);
+    }
+    catch (const std::string message) {
+        std::cerr << "Erreur: " << message << std::endl;
+        return 2;
+    }
+
+    if (banque) {
+        return executer_banque(png, argv + optind + 1, argc - optind - 1,
+                               tolerance, seuil, verifier);
+    }
+
+    std::vector<Noyau> etapes;
+
+    try {
+        // Charger le noyau de convolution, ou chacun des noyaux de la chaîne
+        const std::vector<std::string> noms_noyaux =
+            decouper_chaine(argv[optind + 1]);
+
+        etapes.resize(noms_noyaux.size());
+        for (size_t s = 0; s < etapes.size(); ++s)
+            etapes[s].charger(noms_noyaux[s], tolerance, seuil);
+    }
+    catch (const std::string message) {
+        std::cerr << "Erreur: " << message << std::endl;
+        return 3;
+    }
+
+    if (fusionner) {
+        return executer_pipeline(png, etapes, saturer_etapes, verifier,
+            (argc - optind >= 3) ? argv[optind + 2] : "resultat.png");
+    }
+
+    if (etapes.size() > 1) {
+        noyau = composer(etapes, tolerance, seuil);
+        std::cout << "Noyau composé de " << etapes.size() << " étapes"
+            << std::endl;
+    }
+    else {
+        noyau = etapes[0];
+    }
+
+    std::cout << "Dimensions de l'image originale : " << png.largeur()
+        << " x " << png.hauteur() << std::endl;
+    std::cout << "Taille du filtre : " << noyau.largeur();
+    if (noyau.rang() > 0)
+        std::cout << " (rang " << noyau.rang() << ")";
+    if (noyau.symetries()) {
+        std::cout << " (symétries :"
+            << ((noyau.symetries() & SYMETRIE_H) ? " gauche-droite" : "")
+            << ((noyau.symetries() & SYMETRIE_V) ? " haut-bas" : "")
+            << ((noyau.symetries() & SYMETRIE_D) ? " diagonale" : "") << ")";
+    }
+    std::cout << std::endl;
+
+    if (!precedents.empty()) {
+        return executer_incremental(png, noyau, precedents, verifier,
+            (argc - optind >= 3) ? argv[optind + 2] : "resultat.png");
+    }
+
+    if (!bord.empty()) {
+        return executer_bordure(png, noyau, bord, verifier,
+            (argc - optind >= 3) ? argv[optind + 2] : "resultat.png");
+    }
+
+    if (pas > 1) {
+        return executer_decimation(png, noyau, nom_moteur, pas, nb_niveaux,
+            verifier, (argc - optind >= 3) ? argv[optind + 2] : "resultat.png");
+    }
+
+    Moteur moteur;
+    try {
+        moteur = choisir_moteur(nom_moteur, png, noyau);
+    }
+    catch (const std::string message) {
+        std::cerr << "Erreur: " << message << std::endl;
+        return 1;
+    }
+
+    LePNG * reference = verifier ? new LePNG(png) : NULL;
+
+    // Calcul principal
+    auto debut = std::chrono::steady_clock::now();
+    moteur(png, noyau);
+    std::chrono::duration<double> duree =
+        std::chrono::steady_clock::now() - debut;
+    std::cout << "Moteur " << nom_moteur << " : " << duree.count()
+        << " s" << std::endl;
+
+    if (reference) {
+        debut = std::chrono::steady_clock::now();
+        prod_conv_direct(*reference, noyau);
+        duree = std::chrono::steady_clock::now() - debut;
+        std::cout << "Moteur direct : " << duree.count() << " s" << std::endl;
+        std::cout << "Écart maximal avec le moteur direct : "
+            << ecart_max(png, *reference) << std::endl;
+        delete reference;
+    }
+
+    try {
+        // Enregistrer le résultat
+        std::string fichier_resultat =
+            (argc - optind >= 3) ? argv[optind + 2] : "resultat.png";
+        png.enregistrer(fichier_resultat);
+
+        std::cout << "L'image a été filtrée et enregistrée dans "
+            << fichier_resultat << " avec succès!" << std::endl;
+    }
+    catch (const std::string message) {
+        std::cerr << "Erreur: " << message << std::endl;
+        return 4;
+    }
+
+    return 0;
+}
@@ -8,6 +8,7 @@
 
 
 #include "lodepng.h"
+#include <algorithm>
 #include <iostream>
 #include <stdlib.h>
 #include <fstream>
@@ -49,6 +50,59 @@ void encode(const char* inFilename, vector<unsigned char>& inImage, unsigned int
         cout << "Erreur d'encodage " << lError << ": "<< lodepng_error_text(lError) << endl;
 }
 
+//Échanger les lignes de halo entre processus : le processus r possède les
+//lignes [inOwn[r], inOwn[r+1]) et a besoin des lignes [inNeedBegin[r],
+//inNeedEnd[r]), rangées dans ioBand à partir de sa ligne inNeedBegin[r].
+//À l'étape d, chaque processus envoie au processus + d les lignes qu'il
+//possède dans le halo du haut de celui-ci et reçoit du processus - d celles
+//de son propre halo, puis de même vers le haut (MPI_Sendrecv). Une étape
+//suffit, sauf si lHalfK dépasse la hauteur des bandes voisines.
+void exchangeHalos(unsigned char* ioBand, unsigned int inWidth, MPI_Datatype inRow,
+                   const vector<int>& inOwn, const vector<int>& inNeedBegin,
+                   const vector<int>& inNeedEnd, int inRank, int inSize)
+{
+    //Nombre d'étapes, le même pour tous les processus
+    int lSteps = 0;
+    for (int q = 0; q < inSize; q++) {
+        for (int r = q - 1; r >= 0 && inOwn[r + 1] > inNeedBegin[q]; r--)
+            lSteps = max(lSteps, q - r);
+        for (int r = q + 1; r < inSize && inOwn[r] < inNeedEnd[q]; r++)
+            lSteps = max(lSteps, r - q);
+    }
+
+    const int lBegin = inOwn[inRank];
+    const int lEnd = inOwn[inRank + 1];
+
+    for (int d = 1; d <= lSteps; d++) {
+        int lBelow = (inRank + d < inSize) ? inRank + d : MPI_PROC_NULL;
+        int lAbove = (inRank - d >= 0) ? inRank - d : MPI_PROC_NULL;
+
+        //Lignes [lSend0, lSend1) envoyées et [lRecv0, lRecv1) reçues, dans
+        //les deux sens
+        for (int lDir = 0; lDir < 2; lDir++) {
+            int lTo = lDir == 0 ? lBelow : lAbove;
+            int lFrom = lDir == 0 ? lAbove : lBelow;
+            int lSend0 = 0, lSend1 = 0, lRecv0 = 0, lRecv1 = 0;
+            if (lTo != MPI_PROC_NULL) {
+                lSend0 = max(lBegin, lDir == 0 ? inNeedBegin[lTo] : inOwn[lTo + 1]);
+                lSend1 = min(lEnd, lDir == 0 ? inOwn[lTo] : inNeedEnd[lTo]);
+            }
+            if (lFrom != MPI_PROC_NULL) {
+                lRecv0 = max(inOwn[lFrom], lDir == 0 ? inNeedBegin[inRank] : lEnd);
+                lRecv1 = min(inOwn[lFrom + 1], lDir == 0 ? lBegin : inNeedEnd[inRank]);
+            }
+            int lSendCount = max(0, lSend1 - lSend0);
+            int lRecvCount = max(0, lRecv1 - lRecv0);
+            if (lSendCount == 0) lSend0 = lBegin;
+            if (lRecvCount == 0) lRecv0 = lBegin;
+
+            MPI_Sendrecv(ioBand + size_t(lSend0 - inNeedBegin[inRank])*inWidth*4, lSendCount, inRow, lTo, lDir,
+                         ioBand + size_t(lRecv0 - inNeedBegin[inRank])*inWidth*4, lRecvCount, inRow, lFrom, lDir,
+                         MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        }
+    }
+}
+
 int main(int inArgc, char *inArgv[])
 {
     MPI_Init(&inArgc, &inArgv);
@@ -66,150 +120,178 @@ int main(int inArgc, char *inArgv[])
     MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
     MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
 
-    // Lire le noyau.
-    ifstream lConfig;
-    lConfig.open(inArgv[2]);
-    if (!lConfig.is_open()) {
-        cerr << "Le fichier noyau fourni (" << inArgv[2] << ") est invalide." << endl;
-        MPI_Abort(MPI_COMM_WORLD, 1);
-    }
-    
-    PACC::Tokenizer lTok(lConfig);
-    lTok.setDelimiters(" \n","");
-        
-    string lToken;
-    lTok.getNextToken(lToken);
-    
-    int lK = atoi(lToken.c_str());
-    int lHalfK = lK/2;
+    // Lire le noyau, au rang 0 seulement, puis le diffuser aux autres rangs
+    int lK = 0;
+    double* lFilter = NULL;
 
     if (mpiRank == 0) {
+        ifstream lConfig;
+        lConfig.open(inArgv[2]);
+        if (!lConfig.is_open()) {
+            cerr << "Le fichier noyau fourni (" << inArgv[2] << ") est invalide." << endl;
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        
+        PACC::Tokenizer lTok(lConfig);
+        lTok.setDelimiters(" \n","");
+            
+        string lToken;
+        lTok.getNextToken(lToken);
+        
+        lK = atoi(lToken.c_str());
+
         cout << "Taille du noyau: " <<  lK << endl;
-    }
-    
-    //Lecture du filtre
-    double* lFilter = new double[lK*lK];
         
-    for (int i = 0; i < lK; i++) {
-        for (int j = 0; j < lK; j++) {
-            lTok.getNextToken(lToken);
-            lFilter[i*lK+j] = atof(lToken.c_str());
+        //Lecture du filtre
+        lFilter = new double[lK*lK];
+            
+        for (int i = 0; i < lK; i++) {
+            for (int j = 0; j < lK; j++) {
+                lTok.getNextToken(lToken);
+                lFilter[i*lK+j] = atof(lToken.c_str());
+            }
         }
     }
 
+    MPI_Bcast(&lK, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if (mpiRank != 0)
+        lFilter = new double[lK*lK];
+    MPI_Bcast(lFilter, lK*lK, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+    int lHalfK = lK/2;
+
     //Lecture de l'image
     //Variables à remplir
-    unsigned int lWidth, lHeight; 
-    vector<unsigned char> lImage;   //Les pixels bruts
+    unsigned int lWidth = 0, lHeight = 0; 
+    vector<unsigned char> lImage;   //Les pixels bruts, au rang 0 seulement
     vector<unsigned char> outImage; //pixels de l'image apres le filtre
     
     
-    //Appeler lodepng
-    decode(lFilename.c_str(), lImage, lWidth, lHeight);
-    outImage.resize((int)lWidth*(int)lHeight*4);
+    //Appeler lodepng au rang 0 seulement
+    if (mpiRank == 0) {
+        decode(lFilename.c_str(), lImage, lWidth, lHeight);
+        outImage.resize((int)lWidth*(int)lHeight*4);
+    }
+
+    unsigned int lDimensions[2] = {lWidth, lHeight};
+    MPI_Bcast(lDimensions, 2, MPI_UNSIGNED, 0, MPI_COMM_WORLD);
+    lWidth = lDimensions[0];
+    lHeight = lDimensions[1];
+
+    // Limites de chaque processus : lignes calculées [yDebut, yFin), lignes
+    // lues [yDebut - lHalfK, yFin + lHalfK). Les lignes possédées [lOwn[r],
+    // lOwn[r+1]), disjointes, sont les lignes calculées, plus la bordure du
+    // haut et du bas pour le premier et le dernier processus.
+    vector<int> lOwn(mpiSize + 1), lNeedBegin(mpiSize), lNeedEnd(mpiSize);
+    vector<int> lCounts(mpiSize), lDispls(mpiSize);
+    vector<int> lBandCounts(mpiSize), lBandDispls(mpiSize);
+    for (int rank = 0; rank < mpiSize; rank++)
+    {
+        int yDebut = lHalfK + (lHeight - 2 * lHalfK) * (rank + 0) / mpiSize;
+        int yFin = lHalfK + (lHeight - 2 * lHalfK) * (rank + 1) / mpiSize;
+        lOwn[rank] = rank == 0 ? 0 : yDebut;
+        lNeedBegin[rank] = yDebut - lHalfK;
+        lNeedEnd[rank] = yFin + lHalfK;
+        lBandCounts[rank] = yFin - yDebut;
+        lBandDispls[rank] = yDebut;
+    }
+    lOwn[mpiSize] = lHeight;
+    for (int rank = 0; rank < mpiSize; rank++)
+    {
+        lCounts[rank] = lOwn[rank + 1] - lOwn[rank];
+        lDispls[rank] = lOwn[rank];
+    }
 
     // Limites du present processus
     int ymin = lHalfK + (lHeight - 2 * lHalfK) * (mpiRank + 0) / mpiSize;
     int ymax = lHalfK + (lHeight - 2 * lHalfK) * (mpiRank + 1) / mpiSize;
+
+    // Comptes et déplacements en lignes, pour ne pas déborder d'un int
+    // au-delà de 2 Gio d'image
+    MPI_Datatype lRowType;
+    MPI_Type_contiguous(lWidth*4, MPI_UNSIGNED_CHAR, &lRowType);
+    MPI_Type_commit(&lRowType);
+
+    // Le rang 0 distribue à chaque processus les lignes qu'il possède, puis
+    // les processus voisins échangent les lHalfK lignes de part et d'autre ;
+    // chaque processus n'alloue que sa bande
+    vector<unsigned char> lBand(size_t(ymax - ymin + 2 * lHalfK)*lWidth*4); //Lignes ymin - lHalfK .. ymax + lHalfK - 1
+    vector<unsigned char> outBand(size_t(ymax - ymin)*lWidth*4);           //Lignes ymin .. ymax - 1
+    MPI_Scatterv(lImage.data(), lCounts.data(), lDispls.data(), lRowType,
+                 lBand.data() + size_t(lOwn[mpiRank] - lNeedBegin[mpiRank])*lWidth*4,
+                 lCounts[mpiRank], lRowType, 0, MPI_COMM_WORLD);
+    exchangeHalos(lBand.data(), lWidth, lRowType, lOwn, lNeedBegin, lNeedEnd, mpiRank, mpiSize);
     
+    //Tuiles de calcul : lTileH lignes de lTileW pixels. Les lignes de la
+    //bande sont parcourues dans l'ordre de la mémoire (y, puis x) et les
+    //lTileH + lK - 1 morceaux de lignes lus par une tuile restent en cache
+    //d'une ligne à l'autre, même pour les images très larges. Les indices y
+    //sont relatifs à ymin ; la ligne y de la bande lue est y + lHalfK.
+    const int lTileW = 256;
+    const int lTileH = 32;
+
     //Variables contenant des indices
     int fy, fx;
     //Variables temporaires pour les canaux de l'image
     double lR, lG, lB;    
-    for (int y = ymin; y < ymax; y++)
+    for (int ty = 0; ty < ymax - ymin; ty += lTileH)
     {
-        for (int x = lHalfK; x < (int)lWidth - lHalfK; x++)
+        int tyFin = min(ty + lTileH, ymax - ymin);
+        for (int tx = lHalfK; tx < (int)lWidth - lHalfK; tx += lTileW)
         {
-            lR = 0.;
-            lG = 0.;
-            lB = 0.;
-            for (int j = -lHalfK; j <= lHalfK; j++) {
-                fy = j + lHalfK;
-                for (int i = -lHalfK; i <= lHalfK; i++) {
-                    fx = i + lHalfK;
-                    //R[x + i, y + j] = Im[x + i, y + j].R * Filter[i, j]
-                    lR += double(lImage[(y + j)*lWidth*4 + (x + i)*4    ]) * lFilter[fx + fy*lK];
-                    lG += double(lImage[(y + j)*lWidth*4 + (x + i)*4 + 1]) * lFilter[fx + fy*lK];
-                    lB += double(lImage[(y + j)*lWidth*4 + (x + i)*4 + 2]) * lFilter[fx + fy*lK];
+            int txFin = min(tx + lTileW, (int)lWidth - lHalfK);
+            for (int y = ty; y < tyFin; y++)
+            {
+                for (int x = tx; x < txFin; x++)
+                {
+                    lR = 0.;
+                    lG = 0.;
+                    lB = 0.;
+                    for (int j = -lHalfK; j <= lHalfK; j++) {
+                        fy = j + lHalfK;
+                        int lRow = (y + lHalfK + j)*lWidth*4;
+                        for (int i = -lHalfK; i <= lHalfK; i++) {
+                            fx = i + lHalfK;
+                            //R[x + i, y + j] = Im[x + i, y + j].R * Filter[i, j]
+                            lR += double(lBand[lRow + (x + i)*4    ]) * lFilter[fx + fy*lK];
+                            lG += double(lBand[lRow + (x + i)*4 + 1]) * lFilter[fx + fy*lK];
+                            lB += double(lBand[lRow + (x + i)*4 + 2]) * lFilter[fx + fy*lK];
 
+                        }
+                    }
+                    //protection contre la saturation
+                    if(lR<0.) {lR=0.;} if(lR>255.) {lR=255.;}
+                    if(lG<0.) {lG=0.;} if(lG>255.) {lG=255.;}
+                    if(lB<0.) {lB=0.;} if(lB>255.) {lB=255.;}
+                    //Placer le résultat dans la bande.
+                    outBand[y*lWidth*4 + x*4] = (unsigned char)lR;
+                    outBand[y*lWidth*4 + x*4 + 1] = (unsigned char)lG;
+                    outBand[y*lWidth*4 + x*4 + 2] = (unsigned char)lB;
+                    outBand[y*lWidth*4 + x*4 + 3] = lBand[(y + lHalfK)*lWidth*4 + x*4 + 3];
                 }
             }
-            //protection contre la saturation
-            if(lR<0.) lR=0.; if(lR>255.) lR=255.;
-            if(lG<0.) lG=0.; if(lG>255.) lG=255.;
-            if(lB<0.) lB=0.; if(lB>255.) lB=255.;
-            //Placer le résultat dans l'image.
-            outImage[y*lWidth*4 + x*4] = (unsigned char)lR;
-            outImage[y*lWidth*4 + x*4 + 1] = (unsigned char)lG;
-            outImage[y*lWidth*4 + x*4 + 2] = (unsigned char)lB;
-            outImage[y*lWidth*4 + x*4 + 3] = lImage[y*lWidth*4 + x*4 + 3];
         }
     }
 
-    // Copier la bordure gauche du morceau
-    for (int y = ymin; y < ymax; y++)
+    // Copier les bordures gauche et droite du morceau, en un seul passage
+    for (int y = 0; y < ymax - ymin; y++)
     {
-        for(int x = 0; x < lHalfK; x++)
-        {
-            outImage[y*lWidth*4 + x*4] = lImage[y*lWidth*4 + x*4];
-            outImage[y*lWidth*4 + x*4 + 1] = lImage[y*lWidth*4 + x*4 + 1];
-            outImage[y*lWidth*4 + x*4 + 2] = lImage[y*lWidth*4 + x*4 + 2];
-            outImage[y*lWidth*4 + x*4 + 3] = lImage[y*lWidth*4 + x*4 + 3];
-        }
+        const unsigned char* lIn = &lBand[(y + lHalfK)*lWidth*4];
+        unsigned char* lOut = &outBand[y*lWidth*4];
+        copy(lIn, lIn + lHalfK*4, lOut);
+        copy(lIn + (lWidth - lHalfK)*4, lIn + lWidth*4, lOut + (lWidth - lHalfK)*4);
     }
 
-    // Copier la bordure droite du morceau
-    for (int y = ymin; y < ymax; y++)
-    {
-        for(int x = (int)lWidth-lHalfK; x < (int)lWidth; x++)
-        {
-            outImage[y*lWidth*4 + x*4] = lImage[y*lWidth*4 + x*4];
-            outImage[y*lWidth*4 + x*4 + 1] = lImage[y*lWidth*4 + x*4 + 1];
-            outImage[y*lWidth*4 + x*4 + 2] = lImage[y*lWidth*4 + x*4 + 2];
-            outImage[y*lWidth*4 + x*4 + 3] = lImage[y*lWidth*4 + x*4 + 3];
-        }
-    }
+    // Rassembler les bandes filtrées au rang 0
+    MPI_Gatherv(outBand.data(), lBandCounts[mpiRank], lRowType,
+                outImage.data(), lBandCounts.data(), lBandDispls.data(),
+                lRowType, 0, MPI_COMM_WORLD);
+    MPI_Type_free(&lRowType);
 
     if (mpiRank == 0) {
-        MPI_Status mstatus;
-
-        // Copier toute la bordure du haut de l'image
-        for (int y = 0; y < lHalfK; y++)
-        {
-            for(int x = 0; x < (int)lWidth; x++)
-            {
-                outImage[y*lWidth*4 + x*4] = lImage[y*lWidth*4 + x*4];
-                outImage[y*lWidth*4 + x*4 + 1] = lImage[y*lWidth*4 + x*4 + 1];
-                outImage[y*lWidth*4 + x*4 + 2] = lImage[y*lWidth*4 + x*4 + 2];
-                outImage[y*lWidth*4 + x*4 + 3] = lImage[y*lWidth*4 + x*4 + 3];
-            }
-        }
-
-        for (int rank = 1; rank < mpiSize; rank++)
-        {
-            // Limites du present processus
-            ymin = lHalfK + (lHeight - 2 * lHalfK) * (rank + 0) / mpiSize;
-            ymax = lHalfK + (lHeight - 2 * lHalfK) * (rank + 1) / mpiSize;
-            MPI_Recv(&outImage[ymin * lWidth * 4], (ymax - ymin) * lWidth * 4,
-                     MPI_UNSIGNED_CHAR, rank, MPI_ANY_TAG, MPI_COMM_WORLD, &mstatus);
-        }
-
-        // Copier toute la bordure du bas de l'image
-        for (int y = (int)lHeight - lHalfK; y < (int)lHeight; y++)
-        {
-            for(int x = 0; x < (int)lWidth; x++)
-            {
-                outImage[y*lWidth*4 + x*4] = lImage[y*lWidth*4 + x*4];
-                outImage[y*lWidth*4 + x*4 + 1] = lImage[y*lWidth*4 + x*4 + 1];
-                outImage[y*lWidth*4 + x*4 + 2] = lImage[y*lWidth*4 + x*4 + 2];
-                outImage[y*lWidth*4 + x*4 + 3] = lImage[y*lWidth*4 + x*4 + 3];
-            }
-        }
-    }
-    else
-    {
-        MPI_Send(&outImage[ymin * lWidth * 4], (ymax - ymin) * lWidth * 4,
-                 MPI_UNSIGNED_CHAR, 0, 12345, MPI_COMM_WORLD);
+        // Copier toute la bordure du haut et du bas de l'image
+        copy(lImage.begin(), lImage.begin() + lHalfK*lWidth*4, outImage.begin());
+        copy(lImage.end() - lHalfK*lWidth*4, lImage.end(), outImage.end() - lHalfK*lWidth*4);
     }
     
     //Sauvegarde de l'image dans un fichier sortie
@@ -0,0 +1,204 @@
+//
+//  OrdonnanceurTuiles.hpp
+//  Répartition de tuiles 2D par vol de travail
+//
+//  Un bassin de fils d'exécution persistants reçoit une liste de tuiles.
+//  Chaque fil commence par un bloc contigu de tuiles dans sa propre file ;
+//  une fois sa file vide, il vole des tuiles à la fin de la file d'une
+//  victime choisie au hasard. Les tuiles du bord de l'image, plus rapides,
+//  les coeurs hétérogènes et les autres tâches du noeud ne laissent ainsi
+//  aucun fil inactif à la fin du calcul, contrairement à schedule(static).
+//
+
+#ifndef OrdonnanceurTuiles_hpp_
+#define OrdonnanceurTuiles_hpp_
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+//Rectangle de pixels [mX0, mX1) x [mY0, mY1)
+struct Tuile {
+    int mX0, mY0, mX1, mY1;
+};
+
+//Taille de la cache de données privée d'un coeur (L2), 256 Kio par défaut
+inline size_t tailleCache()
+{
+#ifdef _SC_LEVEL2_CACHE_SIZE
+    long lTaille = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    if (lTaille > 0)
+        return (size_t)lTaille;
+#endif
+    return 256 * 1024;
+}
+
+//Taille des tuiles pour un noyau inK x inK : les (L + K - 1) x (H + K - 1)
+//pixels lus par une tuile occupent au plus la moitié de la cache, L étant
+//un multiple de 16 pixels. La hauteur est ensuite réduite, jusqu'à 8 lignes,
+//pour donner au moins 8 tuiles par fil et laisser du travail à voler.
+inline void tailleTuiles(int inK, int inOctetsParPixel, int inLargeur, int inHauteur,
+                         int inFils, int& outLargeur, int& outHauteur)
+{
+    double lCote = std::sqrt(double(tailleCache()) / 2. / inOctetsParPixel) - (inK - 1);
+    int lCote16 = std::max(16, int(lCote) / 16 * 16);
+
+    outLargeur = std::min(lCote16, std::max(16, inLargeur));
+    outHauteur = std::min(std::max(8, int(lCote)), std::max(1, inHauteur));
+
+    while (outHauteur > 8) {
+        long lNbTuiles = long((inLargeur + outLargeur - 1) / outLargeur)
+                       * ((inHauteur + outHauteur - 1) / outHauteur);
+        if (lNbTuiles >= 8L * inFils)
+            break;
+        outHauteur = std::max(8, outHauteur / 2);
+    }
+}
+
+//Découpage du rectangle [inX0, inX1) x [inY0, inY1) en tuiles, ligne de
+//tuiles par ligne de tuiles (ordre de la mémoire)
+inline std::vector<Tuile> decouperTuiles(int inX0, int inY0, int inX1, int inY1,
+                                         int inLargeur, int inHauteur)
+{
+    std::vector<Tuile> lTuiles;
+    for (int y = inY0; y < inY1; y += inHauteur) {
+        for (int x = inX0; x < inX1; x += inLargeur) {
+            Tuile lTuile = {x, y, std::min(x + inLargeur, inX1), std::min(y + inHauteur, inY1)};
+            lTuiles.push_back(lTuile);
+        }
+    }
+    return lTuiles;
+}
+
+class OrdonnanceurTuiles {
+ public:
+    //Démarrer inFils fils d'exécution, qui attendent le premier travail
+    explicit OrdonnanceurTuiles(int inFils) :
+        mFiles(std::max(1, inFils)), mTravail(NULL), mGeneration(0), mActifs(0), mFin(false)
+    {
+        for (int t = 0; t < (int)mFiles.size(); t++)
+            mFils.push_back(std::thread(&OrdonnanceurTuiles::boucle, this, t));
+    }
+
+    ~OrdonnanceurTuiles()
+    {
+        {
+            std::lock_guard<std::mutex> lVerrou(mMutex);
+            mFin = true;
+        }
+        mReveil.notify_all();
+        for (size_t t = 0; t < mFils.size(); t++)
+            mFils[t].join();
+    }
+
+    int nbFils() const { return (int)mFils.size(); }
+
+    //Appliquer inTravail à chaque tuile et attendre la fin de toutes les tuiles
+    void executer(const std::vector<Tuile>& inTuiles,
+                  const std::function<void(const Tuile&)>& inTravail)
+    {
+        const int lNbFils = nbFils();
+        for (int t = 0; t < lNbFils; t++) {
+            std::lock_guard<std::mutex> lVerrou(mFiles[t].mMutex);
+            mFiles[t].mTuiles.assign(inTuiles.begin() + inTuiles.size() * t / lNbFils,
+                                     inTuiles.begin() + inTuiles.size() * (t + 1) / lNbFils);
+        }
+
+        std::unique_lock<std::mutex> lVerrou(mMutex);
+        mTravail = &inTravail;
+        mActifs = lNbFils;
+        mGeneration++;
+        mReveil.notify_all();
+        mTermine.wait(lVerrou, [this] { return mActifs == 0; });
+        mTravail = NULL;
+    }
+
+ private:
+    //File de tuiles d'un fil d'exécution, sur sa propre ligne de cache (en
+    //C++11, -faligned-new est nécessaire pour que std::vector respecte alignas)
+    struct alignas(64) File {
+        std::mutex mMutex;
+        std::deque<Tuile> mTuiles;
+    };
+
+    OrdonnanceurTuiles(const OrdonnanceurTuiles&);
+    OrdonnanceurTuiles& operator=(const OrdonnanceurTuiles&);
+
+    //Prochaine tuile de sa propre file, dans l'ordre de la mémoire
+    bool prendre(int inId, Tuile& outTuile)
+    {
+        std::lock_guard<std::mutex> lVerrou(mFiles[inId].mMutex);
+        if (mFiles[inId].mTuiles.empty())
+            return false;
+        outTuile = mFiles[inId].mTuiles.front();
+        mFiles[inId].mTuiles.pop_front();
+        return true;
+    }
+
+    //Dernière tuile d'une autre file, à partir d'une victime au hasard. Les
+    //tuiles ne sont jamais ajoutées pendant un travail : si toutes les files
+    //sont vides, il ne reste plus rien à faire.
+    bool voler(int inId, std::minstd_rand& ioAlea, Tuile& outTuile)
+    {
+        const int lNbFils = nbFils();
+        const int lDepart = ioAlea() % lNbFils;
+        for (int v = 0; v < lNbFils; v++) {
+            File& lVictime = mFiles[(lDepart + v) % lNbFils];
+            if ((lDepart + v) % lNbFils == inId)
+                continue;
+            std::lock_guard<std::mutex> lVerrou(lVictime.mMutex);
+            if (!lVictime.mTuiles.empty()) {
+                outTuile = lVictime.mTuiles.back();
+                lVictime.mTuiles.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void boucle(int inId)
+    {
+        std::minstd_rand lAlea(inId + 1);
+        unsigned lGeneration = 0;
+
+        for (;;) {
+            const std::function<void(const Tuile&)>* lTravail;
+            {
+                std::unique_lock<std::mutex> lVerrou(mMutex);
+                mReveil.wait(lVerrou, [&] { return mFin || mGeneration != lGeneration; });
+                if (mFin)
+                    return;
+                lGeneration = mGeneration;
+                lTravail = mTravail;
+            }
+
+            Tuile lTuile;
+            while (prendre(inId, lTuile) || voler(inId, lAlea, lTuile))
+                (*lTravail)(lTuile);
+
+            std::lock_guard<std::mutex> lVerrou(mMutex);
+            if (--mActifs == 0)
+                mTermine.notify_one();
+        }
+    }
+
+    std::vector<File> mFiles;
+    std::vector<std::thread> mFils;
+
+    std::mutex mMutex;
+    std::condition_variable mReveil;
+    std::condition_variable mTermine;
+    const std::function<void(const Tuile&)>* mTravail;
+    unsigned mGeneration;
+    int mActifs;
+    bool mFin;
+};
+
+#endif
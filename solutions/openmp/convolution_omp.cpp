@@ -8,12 +8,14 @@
 
 
 #include "lodepng.h"
+#include <algorithm>
 #include <iostream>
 #include <stdlib.h>
 #include <fstream>
 #include <omp.h>
 
 #include "Chrono.hpp"
+#include "OrdonnanceurTuiles.hpp"
 #include "PACC/Tokenizer.hpp"
 
 using namespace std;
@@ -99,86 +101,63 @@ int main(int inArgc, char *inArgv[])
     decode(lFilename.c_str(), lImage, lWidth, lHeight);
     outImage.resize((int)lWidth*(int)lHeight*4);
     
-    //Variables contenant des indices
-    int fy, fx;
-    //Variables temporaires pour les canaux de l'image
-    double lR, lG, lB;
-    #pragma omp parallel for private(lR,lG,lB,fx,fy) schedule(static) collapse(2)
-    for(int x = lHalfK; x < (int)lWidth - lHalfK; x++)
+    //Tuiles de calcul couvrant toute l'image, réparties par vol de travail
+    //entre omp_get_max_threads() fils d'exécution. Chaque tuile parcourt ses
+    //lignes dans l'ordre de la mémoire (y, puis x) ; sa taille dépend de lK
+    //et de la cache pour que les morceaux de lignes lus y restent.
+    int lTileW, lTileH;
+    OrdonnanceurTuiles lOrdonnanceur(omp_get_max_threads());
+    tailleTuiles(lK, 4, lWidth, lHeight, lOrdonnanceur.nbFils(), lTileW, lTileH);
+    vector<Tuile> lTuiles = decouperTuiles(0, 0, lWidth, lHeight, lTileW, lTileH);
+
+    lOrdonnanceur.executer(lTuiles, [&](const Tuile& inTuile)
     {
-        for (int y = lHalfK; y < (int)lHeight - lHalfK; y++)
-        {
-            lR = 0.;
-            lG = 0.;
-            lB = 0.;
-            for (int j = -lHalfK; j <= lHalfK; j++) {
-                fy = j + lHalfK;
-                for (int i = -lHalfK; i <= lHalfK; i++) {
-                    fx = i + lHalfK;
-                    //R[x + i, y + j] = Im[x + i, y + j].R * Filter[i, j]
-                    lR += double(lImage[(y + j)*lWidth*4 + (x + i)*4    ]) * lFilter[fx + fy*lK];
-                    lG += double(lImage[(y + j)*lWidth*4 + (x + i)*4 + 1]) * lFilter[fx + fy*lK];
-                    lB += double(lImage[(y + j)*lWidth*4 + (x + i)*4 + 2]) * lFilter[fx + fy*lK];
+        //Colonnes de la tuile où le noyau ne déborde pas
+        int xDebut = max(inTuile.mX0, lHalfK);
+        int xFin = max(xDebut, min(inTuile.mX1, (int)lWidth - lHalfK));
 
+        for (int y = inTuile.mY0; y < inTuile.mY1; y++)
+        {
+            const unsigned char* lIn = &lImage[y*lWidth*4];
+            unsigned char* lOut = &outImage[y*lWidth*4];
+
+            //copie les bordures de l'image : lignes du haut et du bas, lHalfK
+            //pixels de gauche et de droite
+            if (y < lHalfK || y >= (int)lHeight - lHalfK) {
+                copy(lIn + inTuile.mX0*4, lIn + inTuile.mX1*4, lOut + inTuile.mX0*4);
+                continue;
+            }
+            copy(lIn + inTuile.mX0*4, lIn + xDebut*4, lOut + inTuile.mX0*4);
+            copy(lIn + xFin*4, lIn + inTuile.mX1*4, lOut + xFin*4);
+
+            for (int x = xDebut; x < xFin; x++)
+            {
+                double lR = 0.;
+                double lG = 0.;
+                double lB = 0.;
+                for (int j = -lHalfK; j <= lHalfK; j++) {
+                    int fy = j + lHalfK;
+                    for (int i = -lHalfK; i <= lHalfK; i++) {
+                        int fx = i + lHalfK;
+                        //R[x + i, y + j] = Im[x + i, y + j].R * Filter[i, j]
+                        lR += double(lImage[(y + j)*lWidth*4 + (x + i)*4    ]) * lFilter[fx + fy*lK];
+                        lG += double(lImage[(y + j)*lWidth*4 + (x + i)*4 + 1]) * lFilter[fx + fy*lK];
+                        lB += double(lImage[(y + j)*lWidth*4 + (x + i)*4 + 2]) * lFilter[fx + fy*lK];
+
+                    }
                 }
+                //protection contre la saturation
+                if(lR<0.) {lR=0.;} if(lR>255.) {lR=255.;}
+                if(lG<0.) {lG=0.;} if(lG>255.) {lG=255.;}
+                if(lB<0.) {lB=0.;} if(lB>255.) {lB=255.;}
+                //Placer le résultat dans l'image.
+                lOut[x*4] = (unsigned char)lR;
+                lOut[x*4 + 1] = (unsigned char)lG;
+                lOut[x*4 + 2] = (unsigned char)lB;
+                lOut[x*4 + 3] = lIn[x*4 + 3];
             }
-            //protection contre la saturation
-            if(lR<0.) lR=0.; if(lR>255.) lR=255.;
-            if(lG<0.) lG=0.; if(lG>255.) lG=255.;
-            if(lB<0.) lB=0.; if(lB>255.) lB=255.;
-            //Placer le résultat dans l'image.
-            outImage[y*lWidth*4 + x*4] = (unsigned char)lR;
-            outImage[y*lWidth*4 + x*4 + 1] = (unsigned char)lG;
-            outImage[y*lWidth*4 + x*4 + 2] = (unsigned char)lB;
-            outImage[y*lWidth*4 + x*4 + 3] = lImage[y*lWidth*4 + x*4 + 3];
         }
-    }
-    
-    //copie les bordures de l'image
-    #pragma omp parallel for schedule(static) collapse(2)
-    for(int x = 0; x < lHalfK; x++)
-    {
-        for (int y = 0; y < (int)lHeight; y++)
-        {
-            outImage[y*lWidth*4 + x*4] = lImage[y*lWidth*4 + x*4];
-            outImage[y*lWidth*4 + x*4 + 1] = lImage[y*lWidth*4 + x*4 + 1];
-            outImage[y*lWidth*4 + x*4 + 2] = lImage[y*lWidth*4 + x*4 + 2];
-            outImage[y*lWidth*4 + x*4 + 3] = lImage[y*lWidth*4 + x*4 + 3];
-        }
-    }
-    #pragma omp parallel for schedule(static) collapse(2)
-    for(int x = (int)lWidth-lHalfK; x < (int)lWidth; x++)
-    {
-        for (int y = 0; y < (int)lHeight; y++)
-        {
-            outImage[y*lWidth*4 + x*4] = lImage[y*lWidth*4 + x*4];
-            outImage[y*lWidth*4 + x*4 + 1] = lImage[y*lWidth*4 + x*4 + 1];
-            outImage[y*lWidth*4 + x*4 + 2] = lImage[y*lWidth*4 + x*4 + 2];
-            outImage[y*lWidth*4 + x*4 + 3] = lImage[y*lWidth*4 + x*4 + 3];
-        }
-    }
-    #pragma omp parallel for schedule(static) collapse(2)
-    for(int x = lHalfK; x < (int)lWidth - lHalfK; x++)
-    {
-        for (int y = 0; y < lHalfK; y++)
-        {
-            outImage[y*lWidth*4 + x*4] = lImage[y*lWidth*4 + x*4];
-            outImage[y*lWidth*4 + x*4 + 1] = lImage[y*lWidth*4 + x*4 + 1];
-            outImage[y*lWidth*4 + x*4 + 2] = lImage[y*lWidth*4 + x*4 + 2];
-            outImage[y*lWidth*4 + x*4 + 3] = lImage[y*lWidth*4 + x*4 + 3];
-        }
-    }
-    #pragma omp parallel for schedule(static) collapse(2)
-    for(int x = lHalfK; x < (int)lWidth - lHalfK; x++)
-    {
-        for (int y = (int)lHeight - lHalfK; y < (int)lHeight; y++)
-        {
-            outImage[y*lWidth*4 + x*4] = lImage[y*lWidth*4 + x*4];
-            outImage[y*lWidth*4 + x*4 + 1] = lImage[y*lWidth*4 + x*4 + 1];
-            outImage[y*lWidth*4 + x*4 + 2] = lImage[y*lWidth*4 + x*4 + 2];
-            outImage[y*lWidth*4 + x*4 + 3] = lImage[y*lWidth*4 + x*4 + 3];
-        }
-    }
+    });
     
     //Sauvegarde de l'image dans un fichier sortie
     encode(lOutFilename.c_str(),  outImage, lWidth, lHeight);
@@ -0,0 +1 @@
+../openmp/OrdonnanceurTuiles.hpp
\ No newline at end of file
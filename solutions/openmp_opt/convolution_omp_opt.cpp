@@ -11,8 +11,10 @@
 #include <iostream>
 #include <stdlib.h>
 #include <fstream>
+#include <omp.h>
 
 #include "Chrono.hpp"
+#include "OrdonnanceurTuiles.hpp"
 #include "PACC/Tokenizer.hpp"
 
 using namespace std;
@@ -103,43 +105,51 @@ int main(int inArgc, char *inArgv[])
         for (int j = 0; j < 4; j++)
             dlImage[j*lWidth*lHeight+i] = double(lImage[i*4+j]);
 
-    //Variables contenant des indices
-    int fy;
-    //Variables temporaires pour les canaux de l'image
-    double lR, lG, lB;
-#pragma omp parallel for private(lR, lG, lB, fy)
-    for (int y = lHalfK; y < (int)lHeight - lHalfK; y++)
+    //Tuiles de calcul, réparties par vol de travail entre
+    //omp_get_max_threads() fils d'exécution ; leur taille dépend de lK et de
+    //la cache (3 plans double, 24 octets par pixel)
+    int lTileW, lTileH;
+    OrdonnanceurTuiles lOrdonnanceur(omp_get_max_threads());
+    tailleTuiles(lK, 3*sizeof(double), lWidth - 2*lHalfK, lHeight - 2*lHalfK,
+                 lOrdonnanceur.nbFils(), lTileW, lTileH);
+    vector<Tuile> lTuiles = decouperTuiles(lHalfK, lHalfK, (int)lWidth - lHalfK,
+                                           (int)lHeight - lHalfK, lTileW, lTileH);
+
+    lOrdonnanceur.executer(lTuiles, [&](const Tuile& inTuile)
     {
-        for(int x = lHalfK; x < (int)lWidth - lHalfK; x++)
+        for (int y = inTuile.mY0; y < inTuile.mY1; y++)
         {
-            lR = 0.;
-            lG = 0.;
-            lB = 0.;
-            for (int j = -lHalfK; j <= lHalfK; j++) {
-                int offR = (y+j)*lWidth + x;
-                int offG = lWidth*lHeight + (y+j)*lWidth + x;
-                int offB = 2*lWidth*lHeight + (y+j)*lWidth + x;
-                fy = j + lHalfK;
-                int offFilter = lHalfK + fy*lK;
+            for(int x = inTuile.mX0; x < inTuile.mX1; x++)
+            {
+                double lR = 0.;
+                double lG = 0.;
+                double lB = 0.;
+                for (int j = -lHalfK; j <= lHalfK; j++) {
+                    int offR = (y+j)*lWidth + x;
+                    int offG = lWidth*lHeight + (y+j)*lWidth + x;
+                    int offB = 2*lWidth*lHeight + (y+j)*lWidth + x;
+                    int fy = j + lHalfK;
+                    int offFilter = lHalfK + fy*lK;
 #pragma omp simd reduction(+:lR,lG,lB)
-                for (int i = -lHalfK; i <= lHalfK; i++) {
-                    //R[x + i, y + j] = Im[x + i, y + j].R * Filter[i, j]
-                    lR += dlImage[offR+i] * lFilter[offFilter+i];
-                    lG += dlImage[offG+i] * lFilter[offFilter+i];
-                    lB += dlImage[offB+i] * lFilter[offFilter+i];
+                    for (int i = -lHalfK; i <= lHalfK; i++) {
+                        //R[x + i, y + j] = Im[x + i, y + j].R * Filter[i, j]
+                        lR += dlImage[offR+i] * lFilter[offFilter+i];
+                        lG += dlImage[offG+i] * lFilter[offFilter+i];
+                        lB += dlImage[offB+i] * lFilter[offFilter+i];
+                    }
                 }
+                //protection contre la saturation
+                if(lR<0.) {lR=0.;} if(lR>255.) {lR=255.;}
+                if(lG<0.) {lG=0.;} if(lG>255.) {lG=255.;}
+                if(lB<0.) {lB=0.;} if(lB>255.) {lB=255.;}
+                //Placer le résultat dans l'image.
+                outImage[y*lWidth*4 + x*4] = (unsigned char)lR;
+                outImage[y*lWidth*4 + x*4 + 1] = (unsigned char)lG;
+                outImage[y*lWidth*4 + x*4 + 2] = (unsigned char)lB;
+                outImage[y*lWidth*4 + x*4 + 3] = lImage[y*lWidth*4 + x*4 + 3];
             }
-            //protection contre la saturation
-            if(lR<0.) {lR=0.;} if(lR>255.) {lR=255.;}
-            if(lG<0.) {lG=0.;} if(lG>255.) {lG=255.;}
-            if(lB<0.) {lB=0.;} if(lB>255.) {lB=255.;}
-            //Placer le résultat dans l'image.
-            outImage[y*lWidth*4 + x*4] = (unsigned char)lR;
-            outImage[y*lWidth*4 + x*4 + 1] = (unsigned char)lG;
-            outImage[y*lWidth*4 + x*4 + 2] = (unsigned char)lB;
-            outImage[y*lWidth*4 + x*4 + 3] = lImage[y*lWidth*4 + x*4 + 3];
         }
-    }
+    });
 
     //copie les bordures de l'image
     for (int y = 0; y < (int)lHeight; y++)